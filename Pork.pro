@@ -4,10 +4,12 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+CONFIG += c++17
+
 TARGET = Pork
 TEMPLATE = app
 
@@ -24,16 +26,50 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 
 SOURCES += \
+    animationplayer.cpp \
         main.cpp \
         mainwindow.cpp \
+    benchmark.cpp \
+    classifier.cpp \
+    dirindex.cpp \
+    filesource.cpp \
+    gridview.cpp \
+    imagecache.cpp \
+    imageview.cpp \
+    inputtrace.cpp \
+    perfhud.cpp \
+    previewstore.cpp \
+    resampler.cpp \
+    singleinstance.cpp \
+    thumbnailer.cpp \
+    tiledimage.cpp \
+    trace.cpp \
     utils.cpp \
-    videoplayer.cpp
+    videoplayer.cpp \
+    watchdog.cpp
 
 HEADERS += \
+    animationplayer.h \
         mainwindow.h \
+    benchmark.h \
+    classifier.h \
+    dirindex.h \
+    filesource.h \
+    gridview.h \
+    imagecache.h \
+    imageview.h \
+    inputtrace.h \
+    perfhud.h \
+    previewstore.h \
+    resampler.h \
+    singleinstance.h \
+    thumbnailer.h \
+    tiledimage.h \
+    trace.h \
     utils.h \
     config.h \
-    videoplayer.h
+    videoplayer.h \
+    watchdog.h
 
 FORMS += \
         mainwindow.ui
@@ -0,0 +1,250 @@
+#include "animationplayer.h"
+#include "config.h"
+#include "filesource.h"
+
+#include <QImageReader>
+#include <QBuffer>
+#include <QScopedPointer>
+#include <QtConcurrent>
+
+namespace pork {
+
+AnimationPlayer::AnimationPlayer(QObject *parent)
+    : QObject(parent)
+{
+    // previous decoder may still be finishing while the new one starts
+    m_pool.setMaxThreadCount(2);
+
+    m_frameTimer.setSingleShot(true);
+    connect(&m_frameTimer, &QTimer::timeout, this, &AnimationPlayer::showNextFrame);
+
+    // zoom changes scale every frame. re-decode only once it settles
+    m_rescaleTimer.setSingleShot(true);
+    m_rescaleTimer.setInterval(tune::animation::rescaleDelay);
+    connect(&m_rescaleTimer, &QTimer::timeout, this, &AnimationPlayer::restart);
+}
+
+AnimationPlayer::~AnimationPlayer()
+{
+    stop();
+    m_pool.waitForDone();
+}
+
+void AnimationPlayer::setFileName(const QString &file)
+{
+    stop();
+    m_file = file;
+}
+
+void AnimationPlayer::setScaledSize(const QSize &size)
+{
+    if(size == m_scaledSize) {
+        return;
+    }
+
+    m_scaledSize = size;
+    if(m_generation.load() % 2 == 1) {
+        // playing
+        m_rescaleTimer.start();
+    }
+}
+
+void AnimationPlayer::start()
+{
+    restart();
+}
+
+void AnimationPlayer::stop()
+{
+    // even generation means stopped one
+    if(m_generation.load() % 2 == 1) {
+        m_generation.fetchAndAddOrdered(1);
+    }
+
+    m_frameTimer.stop();
+    m_rescaleTimer.stop();
+
+    QMutexLocker lock(&m_mutex);
+    m_queue.clear();
+    m_queueNotFull.wakeAll();
+}
+
+void AnimationPlayer::restart()
+{
+    stop();
+
+    m_frames.clear();
+    m_index = 0;
+    m_complete = false;
+    m_streaming = false;
+    m_loopCount = -1;
+    m_loop = 0;
+
+    if(m_file.isEmpty()) {
+        return;
+    }
+
+    const int generation { m_generation.fetchAndAddOrdered(1) + 1 };
+    QtConcurrent::run(&m_pool, [this, generation, file = m_file, size = m_scaledSize]() {
+        decode(generation, file, size);
+    });
+
+    m_frameTimer.start(0);
+}
+
+void AnimationPlayer::decode(int generation, const QString &file, const QSize &size)
+{
+    const QSharedPointer<FileSource> source { FileSource::open(file) };
+    QBuffer buffer;
+    QScopedPointer<QImageReader> reader;
+
+    // every loop reads the same mapping, nothing is read from the file again
+    auto rewind = [&]() {
+        buffer.close();
+        reader.reset(new QImageReader);
+        source->attach(*reader, buffer);
+        if(size.isValid()) {
+            reader->setScaledSize(size);
+        }
+    };
+    rewind();
+
+    qint64 bytes {0};
+    bool streaming {false};
+    bool rewound {false};
+    int count {0};
+    int loopCount {-1}; // repeats after the first pass. -1 is forever
+    int loop {0};
+
+    while(m_generation.load() == generation) {
+        // gui thread only uploads frames of display format
+        const QImage image { toDisplayFormat(reader->read()) };
+
+        if(image.isNull()) {
+            // a reader which fails right after rewind would fail forever. that's the end of stream too.
+            // streamed finite animations end after their last loop
+            const bool lastLoop { loopCount >= 0 && loop >= loopCount };
+            if(count == 0 || !streaming || rewound || lastLoop) {
+                // broken file or the whole loop is in gui cache now
+                QMetaObject::invokeMethod(this, [this, generation, loopCount]() {
+                    if(m_generation.load() == generation) {
+                        m_complete = true;
+                        m_loopCount = loopCount;
+                    }
+                }, Qt::QueuedConnection);
+                return;
+            }
+
+            ++loop;
+
+            rewind();
+            rewound = true;
+            continue;
+        }
+
+        if(count == 0) {
+            // netscape loop extension is known once the first frame is read
+            loopCount = reader->loopCount();
+        }
+        ++count;
+        rewound = false;
+        const int delay { reader->nextImageDelay() };
+
+        if(!streaming) {
+            bytes += image.sizeInBytes();
+            if(bytes > static_cast<qint64>(tune::animation::memoryCap)*1024*1024) {
+                streaming = true;
+                QMetaObject::invokeMethod(this, [this, generation]() {
+                    if(m_generation.load() == generation) {
+                        m_streaming = true;
+                    }
+                }, Qt::QueuedConnection);
+            }
+        }
+
+        if(!streaming) {
+            QMetaObject::invokeMethod(this, [this, generation, image, delay]() {
+                if(m_generation.load() == generation) {
+                    m_frames << Frame { QPixmap::fromImage(image), delay };
+                }
+            }, Qt::QueuedConnection);
+            continue;
+        }
+
+        QMutexLocker lock(&m_mutex);
+        while(m_queue.size() >= tune::animation::streamFrames && m_generation.load() == generation) {
+            m_queueNotFull.wait(&m_mutex);
+        }
+        if(m_generation.load() == generation) {
+            m_queue.enqueue(qMakePair(image, delay));
+        }
+    }
+}
+
+void AnimationPlayer::showNextFrame()
+{
+    // replay from memory. the last frame may have been shown before the decoder reported the loop complete
+    if(m_complete && !m_frames.isEmpty() && m_index >= m_frames.size()) {
+        // finite animations stay at their last frame as `QMovie` did
+        if(m_loopCount >= 0 && m_loop >= m_loopCount) {
+            return;
+        }
+        ++m_loop;
+        m_index = 0;
+    }
+
+    if(m_index < m_frames.size()) {
+        const Frame &frame { m_frames[m_index] };
+        ++m_index;
+
+        // still picture needs no more frames
+        if(m_complete && m_frames.size() == 1) {
+            showFrame(frame.pixmap, -1);
+            return;
+        }
+
+        showFrame(frame.pixmap, frame.delay);
+        return;
+    }
+
+    if(m_streaming) {
+        // cached part of the first loop is shown. memory is released for good
+        m_frames.clear();
+        m_index = 0;
+
+        QMutexLocker lock(&m_mutex);
+        if(!m_queue.isEmpty()) {
+            const QPair<QImage, int> frame { m_queue.dequeue() };
+            m_queueNotFull.wakeAll();
+            lock.unlock();
+
+            showFrame(QPixmap::fromImage(frame.first), frame.second);
+            return;
+        }
+    }
+
+    if(m_complete && m_frames.isEmpty()) {
+        // nothing was decoded at all
+        return;
+    }
+
+    // decoder is behind
+    m_frameTimer.start(tune::animation::pollTime);
+}
+
+void AnimationPlayer::showFrame(const QPixmap &pixmap, int delay)
+{
+    // frames of the previous scale are shown until re-decoded ones arrive
+    if(m_scaledSize.isValid() && pixmap.size() != m_scaledSize) {
+        emit frameChanged(pixmap.scaled(m_scaledSize, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+    } else {
+        emit frameChanged(pixmap);
+    }
+
+    if(delay >= 0) {
+        // same as browsers do for zero delays
+        m_frameTimer.start(delay > 0 ? delay : tune::animation::defaultDelay);
+    }
+}
+
+} // namespace pork
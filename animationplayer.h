@@ -0,0 +1,74 @@
+#ifndef ANIMATIONPLAYER_H
+#define ANIMATIONPLAYER_H
+
+#include <QObject>
+#include <QImage>
+#include <QPixmap>
+#include <QVector>
+#include <QQueue>
+#include <QPair>
+#include <QTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+namespace pork {
+
+//! Plays gif/webp animations. Frames are decoded once at the current scale on a worker thread
+//! and replayed from memory after the first loop. Animations exceeding memory budget are
+//! decoded continuously through a small queue of frames instead. Loop count of the file is honoured.
+class AnimationPlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AnimationPlayer(QObject *parent = 0);
+    ~AnimationPlayer();
+
+    void setFileName(const QString &file);
+    void setScaledSize(const QSize &size);
+    void start();
+    void stop();
+
+signals:
+    void frameChanged(const QPixmap &frame);
+
+private:
+    struct Frame
+    {
+        QPixmap pixmap;
+        int delay;
+    };
+
+    void restart();
+    void decode(int generation, const QString &file, const QSize &size);
+    void showNextFrame();
+    void showFrame(const QPixmap &pixmap, int delay);
+
+    QString m_file;
+    QSize m_scaledSize;
+
+    QThreadPool m_pool;
+    QAtomicInt m_generation {0};
+
+    // first loop cache. gui thread only
+    QVector<Frame> m_frames;
+    int m_index {0};
+    bool m_complete {false};
+    bool m_streaming {false};
+    int m_loopCount {-1}; //! repeats after the first pass as the file asks. -1 is forever
+    int m_loop {0};
+
+    // streamed frames. shared with decoder
+    QMutex m_mutex;
+    QWaitCondition m_queueNotFull;
+    QQueue<QPair<QImage, int>> m_queue;
+
+    QTimer m_frameTimer;
+    QTimer m_rescaleTimer;
+};
+
+} // namespace pork
+
+#endif // ANIMATIONPLAYER_H
@@ -0,0 +1,99 @@
+#include "benchmark.h"
+#include "resampler.h"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QPainter>
+#include <QLinearGradient>
+#include <QVector>
+#include <algorithm>
+#include <functional>
+
+namespace pork {
+
+namespace {
+
+constexpr int runs {5};
+
+//! median time of `runs` runs. in ms
+qreal measure(const std::function<void()> &f)
+{
+    QVector<qint64> times;
+    for(int i = 0; i < runs; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        f();
+        times << timer.nsecsElapsed();
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[runs/2]/1e6;
+}
+
+void benchmarkResampler(QTextStream &out)
+{
+    struct Case
+    {
+        const char *name;
+        QSize source;
+        QSize target;
+    };
+
+    const Case cases[] {
+        {"downscale_24mp_to_fhd", {6000, 4000}, {1620, 1080}},
+        {"downscale_24mp_half", {6000, 4000}, {3000, 2000}},
+        {"downscale_fhd_to_tile", {1920, 1080}, {256, 144}},
+        {"upscale_fhd_2x", {1920, 1080}, {3840, 2160}},
+        {"upscale_tile_4x", {256, 256}, {1024, 1024}},
+    };
+
+    for(const auto &c : cases) {
+        const QImage image { syntheticImage(c.source) };
+
+        const qreal qt { measure([&]() {
+            const QImage scaled { image.scaled(c.target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation) };
+            Q_UNUSED(scaled)
+        }) };
+        const qreal pork { measure([&]() {
+            resample(image, c.target);
+        }) };
+
+        out << "resample," << c.name << ',' << resampleKernel() << ','
+            << qt << ',' << pork << ',' << qt/pork << '\n';
+    }
+}
+
+} // namespace
+
+QImage syntheticImage(const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+
+    QLinearGradient gradient(0, 0, size.width(), size.height());
+    gradient.setColorAt(0, Qt::red);
+    gradient.setColorAt(0.5, QColor(0, 255, 0, 128));
+    gradient.setColorAt(1, Qt::blue);
+
+    QPainter painter(&image);
+    painter.fillRect(image.rect(), gradient);
+
+    // high frequency details to make filters work for real
+    painter.setPen(Qt::black);
+    for(int x = 0; x < size.width(); x += 7) {
+        painter.drawLine(x, 0, size.width() - x, size.height());
+    }
+
+    return image;
+}
+
+int runBenchmark()
+{
+    QTextStream out(stdout);
+    out << "group,case,variant,qt_ms,pork_ms,speedup\n";
+
+    benchmarkResampler(out);
+
+    return 0;
+}
+
+} // namespace pork
@@ -0,0 +1,17 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QImage>
+
+namespace pork {
+
+//! Compares resampler filters against Qt scaling and prints it as CSV to stdout. Returns process exit code.
+//! Pipeline timings are not here, they are the `tests/benchmarks` target
+int runBenchmark();
+
+//! Gradient with sharp lines, hard for both codecs and filters. Shared with `tests/benchmarks`
+QImage syntheticImage(const QSize &size);
+
+} // namespace pork
+
+#endif // BENCHMARK_H
@@ -0,0 +1,296 @@
+#include "classifier.h"
+#include "config.h"
+#include "filesource.h"
+
+#include <QSet>
+#include <array>
+#include <cstring>
+
+namespace pork {
+
+namespace {
+
+//! Extensions are packed into integer keys: up to 8 lowercase ASCII chars, one char per byte.
+//! Zero key is reserved for extensions which can't be packed.
+constexpr int maxExtLength {8};
+
+constexpr quint64 pack(std::string_view ext)
+{
+    if(ext.empty() || ext.size() > maxExtLength) {
+        return 0;
+    }
+
+    quint64 key {0};
+    for(size_t i = 0; i < ext.size(); ++i) {
+        char c { ext[i] };
+        if(c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        key |= static_cast<quint64>(static_cast<unsigned char>(c)) << (8*i);
+    }
+    return key;
+}
+
+quint64 pack(const QChar *ext, int length)
+{
+    if(length == 0 || length > maxExtLength) {
+        return 0;
+    }
+
+    quint64 key {0};
+    for(int i = 0; i < length; ++i) {
+        ushort c { ext[i].unicode() };
+        if(c >= 0x80) {
+            return 0;
+        }
+        if(c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        key |= static_cast<quint64>(c) << (8*i);
+    }
+    return key;
+}
+
+quint64 packFileExtension(const QString &file)
+{
+    const int dotIndex { file.lastIndexOf('.') };
+    if(dotIndex == -1) {
+        // no extension
+        return 0;
+    }
+
+    return pack(file.constData() + dotIndex + 1, file.size() - dotIndex - 1);
+}
+
+//! Perfect hash of the fixed video extensions list: multiplicative hash with a seed
+//! found at compile time so that no two extensions share a slot.
+namespace video
+{
+    constexpr int bits {10};
+    constexpr size_t size {size_t{1} << bits};
+
+    constexpr size_t slot(quint64 key, quint64 seed)
+    {
+        return static_cast<size_t>((key * seed) >> (64 - bits));
+    }
+
+    constexpr bool collisionFree(quint64 seed)
+    {
+        std::array<bool, size> used {};
+        for(const auto &ext : cap::supportedVideo) {
+            const size_t s { slot(pack(ext), seed) };
+            if(used[s]) {
+                return false;
+            }
+            used[s] = true;
+        }
+        return true;
+    }
+
+    constexpr quint64 findSeed()
+    {
+        // candidates are taken from splitmix64 sequence. odd ones only to keep multiplication bijective
+        quint64 state {0};
+        for(int i = 0; i < 1000; ++i) {
+            quint64 seed { state += 0x9E3779B97F4A7C15ull };
+            seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+            seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+            seed = (seed ^ (seed >> 31)) | 1;
+            if(collisionFree(seed)) {
+                return seed;
+            }
+        }
+        return 0;
+    }
+
+    constexpr quint64 seed { findSeed() };
+    static_assert(seed != 0, "no perfect hash seed for video extensions, increase `video::bits`");
+
+    constexpr std::array<quint64, size> makeTable()
+    {
+        std::array<quint64, size> table {};
+        for(const auto &ext : cap::supportedVideo) {
+            table[slot(pack(ext), seed)] = pack(ext);
+        }
+        return table;
+    }
+
+    constexpr std::array<quint64, size> table { makeTable() };
+
+    bool contains(quint64 key)
+    {
+        return key && table[slot(key, seed)] == key;
+    }
+}
+
+QSet<quint64> packAll(const QStringList &list)
+{
+    QSet<quint64> res;
+    for(const auto &ext : list) {
+        const quint64 key { pack(ext.constData(), ext.size()) };
+        if(key) {
+            res.insert(key);
+        }
+    }
+    return res;
+}
+
+const QSet<quint64> &gifKeys()
+{
+    static const QSet<quint64> keys { packAll(cap::supportedGif()) };
+    return keys;
+}
+
+const QSet<quint64> &imageKeys()
+{
+    static const QSet<quint64> keys { packAll(cap::supportedImages()) };
+    return keys;
+}
+
+} // namespace
+
+bool classify(const QString &file, MediaMode &mode)
+{
+    const quint64 key { packFileExtension(file) };
+    if(!key) {
+        return false;
+    }
+
+    // check gifs first since *.webp is supported both by `AnimationPlayer`
+    // and simple `QImageReader`. content may be animated, `sniff` tells for sure.
+    if(gifKeys().contains(key)) {
+        mode = MediaMode::Gif;
+        return true;
+    }
+
+    if(imageKeys().contains(key)) {
+        mode = MediaMode::Image;
+        return true;
+    }
+
+    if(video::contains(key)) {
+        mode = MediaMode::Video;
+        return true;
+    }
+
+    return false;
+}
+
+namespace {
+
+//! Bounds checked view of a mapped file
+class Bytes
+{
+public:
+    Bytes(const uchar *data, qint64 size) : m_data(data), m_size(size) {}
+
+    bool has(qint64 pos, qint64 count) const { return pos >= 0 && count >= 0 && pos + count <= m_size; }
+    bool equals(qint64 pos, const char *magic) const
+    {
+        const qint64 count { static_cast<qint64>(std::strlen(magic)) };
+        return has(pos, count) && std::memcmp(m_data + pos, magic, static_cast<size_t>(count)) == 0;
+    }
+    uchar at(qint64 pos) const { return m_data[pos]; }
+    quint32 be32(qint64 pos) const { return quint32(at(pos)) << 24 | quint32(at(pos + 1)) << 16 | quint32(at(pos + 2)) << 8 | at(pos + 3); }
+
+private:
+    const uchar *m_data;
+    qint64 m_size;
+};
+
+//! APNG has `acTL` chunk before the first `IDAT`
+Content sniffPng(const Bytes &bytes)
+{
+    qint64 pos {8};
+    while(bytes.has(pos, 8)) {
+        const qint64 length { bytes.be32(pos) };
+        if(bytes.equals(pos + 4, "acTL")) {
+            return Content::Animation;
+        }
+        if(bytes.equals(pos + 4, "IDAT")) {
+            break;
+        }
+        pos += 12 + length; // length, type, data, crc
+    }
+    return Content::Picture;
+}
+
+//! Animated GIF has more than one image descriptor. Blocks are walked till the second one
+Content sniffGif(const Bytes &bytes)
+{
+    if(!bytes.has(6, 7)) {
+        return Content::Picture;
+    }
+
+    auto skipColorTable = [](qint64 pos, uchar flags) {
+        return (flags & 0x80) ? pos + 3*(2 << (flags & 0x07)) : pos;
+    };
+    auto skipSubBlocks = [&bytes](qint64 pos) {
+        while(bytes.has(pos, 1) && bytes.at(pos) != 0) {
+            pos += bytes.at(pos) + 1;
+        }
+        return pos + 1;
+    };
+
+    qint64 pos { skipColorTable(13, bytes.at(10)) };
+    int frames {0};
+
+    while(bytes.has(pos, 1)) {
+        switch(bytes.at(pos)) {
+            case 0x2C: // image descriptor
+                if(++frames > 1) {
+                    return Content::Animation;
+                }
+                if(!bytes.has(pos, 10)) {
+                    return Content::Picture;
+                }
+                pos = skipColorTable(pos + 10, bytes.at(pos + 9));
+                pos = skipSubBlocks(pos + 1); // LZW minimum code size goes first
+                break;
+            case 0x21: // extension
+                pos = skipSubBlocks(pos + 2);
+                break;
+            default: // trailer or garbage
+                return Content::Picture;
+        }
+    }
+    return Content::Picture;
+}
+
+//! Animated WebP is an extended one with animation flag set
+Content sniffWebp(const Bytes &bytes)
+{
+    if(bytes.equals(12, "VP8X") && bytes.has(20, 1) && (bytes.at(20) & 0x02)) {
+        return Content::Animation;
+    }
+    return Content::Picture;
+}
+
+} // namespace
+
+Content sniff(const FileSource &source)
+{
+    const QByteArray &data { source.bytes() };
+    if(data.size() < 12) {
+        return Content::Unknown;
+    }
+
+    const Bytes bytes { reinterpret_cast<const uchar *>(data.constData()), data.size() };
+
+    if(bytes.equals(0, "\x89PNG\r\n\x1A\n")) {
+        return sniffPng(bytes);
+    }
+    if(bytes.equals(0, "GIF87a") || bytes.equals(0, "GIF89a")) {
+        return sniffGif(bytes);
+    }
+    if(bytes.equals(0, "RIFF") && bytes.equals(8, "WEBP")) {
+        return sniffWebp(bytes);
+    }
+    if(bytes.equals(0, "\xFF\xD8\xFF") || bytes.equals(0, "BM") || bytes.equals(0, "II*") || (bytes.equals(0, "MM") && bytes.equals(3, "*"))) {
+        return Content::Picture;
+    }
+
+    return Content::Unknown;
+}
+
+} // namespace pork
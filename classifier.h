@@ -0,0 +1,27 @@
+#ifndef CLASSIFIER_H
+#define CLASSIFIER_H
+
+#include "utils.h"
+
+namespace pork {
+
+//! Detects media kind of a file by its extension in a single allocation-free lookup.
+//! Returns `false` for unsupported files.
+bool classify(const QString &file, MediaMode &mode);
+
+enum class Content
+{
+    Unknown = 0, //! container is not recognized. extension is all we know then
+    Picture,
+    Animation,
+};
+
+class FileSource;
+
+//! Detects picture container by magic bytes and whether it's animated (GIF, PNG/APNG, WebP).
+//! File is memory mapped, so only the touched header pages are read.
+Content sniff(const FileSource &source);
+
+} // namespace pork
+
+#endif // CLASSIFIER_H
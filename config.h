@@ -5,6 +5,7 @@
 #include <QRgb>
 #include <QImageReader>
 #include <QMovie>
+#include <string_view>
 
 namespace pork {
 
@@ -21,76 +22,68 @@ namespace cap
         return gifs;
     };
 
-    inline const QStringList& supportedVideo() {
-        static const QStringList videos {
-            "3g2",
-            "3gp",
-            "a52",
-            "aac",
-            "asf",
-            "amv",
-            "au",
-            "avi",
-            "drc",
-            "dts",
-            "dv"
-            "dvr-ms",
-            "f4a",
-            "f4b",
-            "f4p",
-            "f4v",
-            "flv",
-            "gifv",
-            "m2ts",
-            "m2v",
-            "m4p",
-            "m4v",
-            "mka",
-            "mkv",
-            "mng",
-            "mov",
-            "mp4",
-            "mpe",
-            "mpeg",
-            "mpg",
-            "mpv",
-            "mts",
-            "mxf",
-            "nsc",
-            "nsv",
-            "nut",
-            "ogg",
-            "ogm",
-            "ogv",
-            "qt",
-            "ra",
-            "ram",
-            "rm",
-            "rmbv",
-            "roq",
-            "rv",
-            "svi",
-            "tac",
-            "ts",
-            "tta",
-            "tsv",
-            "ty",
-            "vid",
-            "viv",
-            "vob",
-            "webm",
-            "wmv",
-            "xa",
-            "yuv",
-        };
-
-        return videos;
+    //! Formats played by libvlc. Looked up through compile-time perfect hash, see `classifier.cpp`
+    constexpr std::string_view supportedVideo[] {
+        "3g2",
+        "3gp",
+        "a52",
+        "aac",
+        "asf",
+        "amv",
+        "au",
+        "avi",
+        "drc",
+        "dts",
+        "dv",
+        "dvr-ms",
+        "f4a",
+        "f4b",
+        "f4p",
+        "f4v",
+        "flv",
+        "gifv",
+        "m2ts",
+        "m2v",
+        "m4p",
+        "m4v",
+        "mka",
+        "mkv",
+        "mng",
+        "mov",
+        "mp4",
+        "mpe",
+        "mpeg",
+        "mpg",
+        "mpv",
+        "mts",
+        "mxf",
+        "nsc",
+        "nsv",
+        "nut",
+        "ogg",
+        "ogm",
+        "ogv",
+        "qt",
+        "ra",
+        "ram",
+        "rm",
+        "rmbv",
+        "roq",
+        "rv",
+        "svi",
+        "tac",
+        "ts",
+        "tta",
+        "tsv",
+        "ty",
+        "vid",
+        "viv",
+        "vob",
+        "webm",
+        "wmv",
+        "xa",
+        "yuv",
     };
-
-    inline const QStringList& supportedFormats() {
-        static const QStringList formats = QStringList() << supportedImages() << supportedGif() << supportedVideo();
-        return formats;
-    }
 }
 
 //! Tuning
@@ -99,6 +92,8 @@ namespace tune
     namespace reg
     {
         static const QString dragWindowGeometry {"dragWindowGeometry"};
+        static const QString previewSize {"previewSize"};
+        static const QString stallThreshold {"stallThreshold"};
     }
 
     namespace screen
@@ -115,6 +110,34 @@ namespace tune
         constexpr int range {1000};    //! slider `maxValue - minValue` range
     }
 
+    namespace view
+    {
+        constexpr int tileSize {256};        //! side of scaled picture tiles. in px
+        constexpr int tileCacheScreens {3};  //! scaled tiles cache limit. in screen sizes
+        constexpr int mipmapMinSize {64};    //! mipmap pyramid stops at this side. in px
+    }
+
+    namespace tiled
+    {
+        constexpr qint64 threshold {100'000'000}; //! pictures with more pixels are decoded by tiles
+        constexpr int overviewSize {4096};        //! overview side limit for tiled pictures. in px
+        constexpr int tileSize {512};             //! side of decoded tiles. in px
+        constexpr int threads {2};                //! worker threads used for tiles decoding
+        constexpr int queueSize {64};             //! requested tiles limit. the oldest ones are dropped
+        constexpr int memoryCap {256};            //! decoded tiles cache limit. in MB
+    }
+
+    namespace decode
+    {
+        constexpr bool reduceDeepColor {true}; //! 16 bits per channel pictures are decoded to 8 bits. halves their memory
+    }
+
+    namespace resample
+    {
+        constexpr int parallelThreshold {512*512}; //! smaller pictures are resampled in a single thread. in px
+        constexpr int stripRows {32};               //! rows of a strip resampled by one thread
+    }
+
     namespace zoom
     {
         constexpr qreal origin {1.0};   //! original zoom (zero zoom)
@@ -128,12 +151,92 @@ namespace tune
         constexpr qreal min {0.0};
         constexpr qreal max {4.0};
 
-        constexpr int delay {5};        //! time between two actual zoom performances. in ms
+        constexpr int settleTime {150}; //! time after the last zoom step when picture is repainted smoothly. in ms
+    }
+
+    namespace dir
+    {
+        constexpr int updateDelay {200}; //! time to collect directory change notifications before index update. in ms
+        constexpr int batchSize {1024};  //! file names passed from directory scanning thread at once
+        constexpr int mergeDelay {250};  //! time to collect scanned batches before they are merged into index. in ms
+    }
+
+    namespace grid
+    {
+        constexpr int cellSize {200};        //! side of a thumbnail grid cell. in px
+        constexpr int pad {8};               //! thumbnail padding inside of a cell. in px
+        constexpr int thumbSize {160};       //! thumbnail side limit. in px
+        constexpr int threads {3};           //! worker threads used for thumbnails decoding
+        constexpr int queueSize {256};       //! requested thumbnails limit. the oldest ones are dropped
+        constexpr int memoryCap {256};       //! thumbnails cache limit. in MB
+        constexpr float videoPosition {0.1f}; //! position of a video snapshot taken as a thumbnail
+        constexpr int videoTimeout {5000};   //! time to give up on a video snapshot. in ms
+        constexpr QRgb background {0x1E1E1E};
+        constexpr QRgb placeholderColor {0x2D2D2D};
+        constexpr QRgb textColor {0xDDDDDD};
+        constexpr QRgb currentColor {0x4A90D9};
+    }
+
+    namespace store
+    {
+        constexpr int diskCap {2048};      //! previews and thumbnails pack file limit. in MB
+        constexpr qreal keepRatio {0.75};  //! part of the limit kept by compaction
+        constexpr int saveEvery {64};      //! new entries written before the index is saved
+    }
+
+    namespace prefetch
+    {
+        constexpr int ahead {3};        //! files decoded in advance in the navigation direction
+        constexpr int behind {1};       //! files kept decoded against the navigation direction
+        constexpr int threads {2};      //! worker threads used for prefetch decoding
+        constexpr int memoryCap {512};  //! decoded images cache limit. in MB
+    }
+
+    namespace animation
+    {
+        constexpr int memoryCap {256};     //! decoded frames limit of a single animation. bigger ones are streamed. in MB
+        constexpr int streamFrames {8};    //! frames decoded in advance while streaming
+        constexpr int rescaleDelay {200};  //! time after the last scale change when frames are re-decoded. in ms
+        constexpr int defaultDelay {100};  //! delay for frames without one. in ms
+        constexpr int pollTime {5};        //! frame retry time when decoder is behind. in ms
+    }
+
+    namespace replay
+    {
+        constexpr int idleTime {100};   //! input with no visible result is over after two such checks. in ms
+        constexpr int timeout {10000};  //! frame of an input is not awaited any longer. in ms
+    }
+
+    namespace watchdog
+    {
+        constexpr int threshold {250};      //! gui event loop blocked longer than this is a stall. in ms
+        constexpr int heartbeat {50};       //! in ms
+        constexpr int checkInterval {25};   //! in ms
+        constexpr int hangTime {5000};      //! stall reported before it's over. in ms
+        constexpr qint64 logSize {1 << 20}; //! log file is rotated once it's bigger. in bytes
+        constexpr int logFiles {3};         //! current log and rotated ones
+    }
+
+    namespace trace
+    {
+        constexpr int threadEvents {1 << 16}; //! trace buffer capacity of every thread. recording of the thread stops when it's full
+    }
+
+    namespace instance
+    {
+        constexpr int timeout {500}; //! running instance connection and files transfer limit. in ms
+    }
+
+    namespace benchmark
+    {
+        constexpr int dirEntries {10000}; //! synthetic directory size of `tests/benchmarks`
     }
 
     namespace video
     {
         constexpr int bufferingTime {400}; //! aproximate time to buffer video
+        constexpr bool warmUp {true};      //! load libvlc in background after the first picture is shown
+        constexpr int warmUpDelay {1000};  //! time after the first picture is shown when libvlc starts loading. in ms
         constexpr qreal rewind {0.05};  //! rewind speed
     }
 
@@ -161,6 +264,14 @@ namespace tune
             constexpr int fontSize {10};
             constexpr int showTime {2000}; //! time when filename label is shown on a screen after file open action. in ms
         }
+
+        namespace hud
+        {
+            constexpr int pad {8};              //! text padding inside the overlay
+            constexpr QRgb color {0xDDDDDD};
+            constexpr int fontSize {9};
+            constexpr int refreshTime {250};    //! in ms
+        }
     }
 }
 
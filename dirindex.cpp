@@ -0,0 +1,250 @@
+#include "dirindex.h"
+#include "config.h"
+#include "classifier.h"
+#include "watchdog.h"
+
+#include <QDir>
+#include <QtConcurrent>
+#include <algorithm>
+#include <iterator>
+
+namespace pork {
+
+static bool lessThan(const QString &a, const QString &b)
+{
+    const int res { a.compare(b, Qt::CaseInsensitive) };
+    return res == 0 ? a < b : res < 0;
+}
+
+DirIndex::DirIndex(QObject *parent)
+    : QObject(parent)
+{
+    // file system notifications come in bursts while files are copied. handle them at once
+    m_updateTimer.setSingleShot(true);
+    connect(&m_updateTimer, &QTimer::timeout, this, &DirIndex::update);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, &m_updateTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    m_updateTimer.setInterval(tune::dir::updateDelay);
+
+    // every merge shifts positions of all the following files and makes neighbours prefetched again
+    m_mergeTimer.setSingleShot(true);
+    m_mergeTimer.setInterval(tune::dir::mergeDelay);
+    connect(&m_mergeTimer, &QTimer::timeout, this, &DirIndex::merge);
+
+    // abandoned scan of the previous directory may still be stopping
+    m_pool.setMaxThreadCount(2);
+}
+
+DirIndex::~DirIndex()
+{
+    m_generation.fetchAndAddOrdered(1);
+    m_pool.waitForDone();
+}
+
+void DirIndex::setPath(const QString &path, const QString &seed)
+{
+    PORK_OPERATION("DirIndex::setPath");
+
+    if(path == m_path) {
+        return;
+    }
+
+    if(!m_path.isEmpty()) {
+        m_watcher.removePath(m_path);
+    }
+    m_updateTimer.stop();
+    m_mergeTimer.stop();
+
+    m_path = path;
+    m_files.clear();
+    m_positions.clear();
+    m_incoming.clear();
+
+    MediaMode mode;
+    if(!seed.isEmpty() && classify(seed, mode)) {
+        m_files << seed;
+        reindex(0);
+    }
+
+    m_watcher.addPath(path);
+    scan(false);
+    emit changed();
+}
+
+void DirIndex::scan(bool refresh)
+{
+    const int generation { m_generation.fetchAndAddOrdered(1) + 1 };
+    m_loading = true;
+    m_outdated = false;
+    m_scanTimer.start();
+
+    QtConcurrent::run(&m_pool, [this, generation, refresh, path = m_path]() {
+        // refresh result is applied at once: files would look gone till they are listed otherwise.
+        // it's collected and sorted here, so the gui thread only diffs it
+        QStringList scanned;
+
+        scanDir(path, [this, generation, refresh, &scanned](const QStringList &batch) {
+            if(m_generation.load() != generation) {
+                return false;
+            }
+
+            if(refresh) {
+                scanned << batch;
+                return true;
+            }
+
+            // batches are merged together a few times per second, not one by one
+            QMetaObject::invokeMethod(this, [this, generation, batch]() {
+                if(m_generation.load() != generation) {
+                    return;
+                }
+
+                m_incoming << batch;
+                if(!m_mergeTimer.isActive()) {
+                    m_mergeTimer.start();
+                }
+            }, Qt::QueuedConnection);
+            return true;
+        });
+
+        if(refresh) {
+            std::sort(scanned.begin(), scanned.end(), lessThan);
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, refresh, scanned]() {
+            if(m_generation.load() != generation) {
+                return;
+            }
+
+            m_loading = false;
+            m_scanTime = m_scanTimer.elapsed();
+            if(refresh) {
+                apply(scanned);
+            } else {
+                m_mergeTimer.stop();
+                merge();
+            }
+
+            if(m_outdated) {
+                scan(true);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void DirIndex::merge()
+{
+    PORK_OPERATION("DirIndex::merge");
+
+    if(m_incoming.isEmpty()) {
+        // index is complete now. navigation wraps around from here
+        emit changed();
+        return;
+    }
+
+    QStringList batch;
+    batch.swap(m_incoming);
+    std::sort(batch.begin(), batch.end(), lessThan);
+    const int from { lowerBound(batch.first()) };
+
+    QStringList files;
+    files.reserve(m_files.size() + batch.size());
+    std::merge(m_files.cbegin(), m_files.cend(), batch.cbegin(), batch.cend(), std::back_inserter(files), lessThan);
+
+    // seed file is listed once again
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    m_files = files;
+    reindex(from);
+    emit changed();
+}
+
+int DirIndex::indexOf(const QString &fileName) const
+{
+    return m_positions.value(fileName, -1);
+}
+
+QString DirIndex::filePath(const QString &fileName) const
+{
+    return QDir(m_path).filePath(fileName);
+}
+
+QString DirIndex::neighbour(const QString &fileName, Direction dir, int distance) const
+{
+    const int count { m_files.size() };
+    if(count == 0) {
+        return QString();
+    }
+
+    int i { indexOf(fileName) };
+    if(i == -1) {
+        // file has gone. its place is between the closest existing neighbours
+        i = lowerBound(fileName);
+        if(dir == Direction::Forward) {
+            --i;
+        }
+    }
+
+    i += dir == Direction::Forward ? distance : -distance;
+
+    // there is no last file to wrap around to till the listing completes
+    if(m_loading) {
+        i = qBound(0, i, count - 1);
+    } else {
+        i = (i % count + count) % count;
+    }
+
+    return m_files[i];
+}
+
+void DirIndex::update()
+{
+    // the running scan may have missed the change. it's repeated when it's done
+    if(m_loading) {
+        m_outdated = true;
+        return;
+    }
+
+    scan(true);
+}
+
+void DirIndex::apply(const QStringList &files)
+{
+    QStringList removed;
+    QStringList added;
+    std::set_difference(m_files.cbegin(), m_files.cend(), files.cbegin(), files.cend(), std::back_inserter(removed), lessThan);
+    std::set_difference(files.cbegin(), files.cend(), m_files.cbegin(), m_files.cend(), std::back_inserter(added), lessThan);
+
+    if(removed.isEmpty() && added.isEmpty()) {
+        return;
+    }
+
+    // only positions after the first changed entry are shifted
+    int from { files.size() };
+
+    for(const auto &file : removed) {
+        from = std::min(from, m_positions.take(file));
+    }
+
+    m_files = files;
+
+    for(const auto &file : added) {
+        from = std::min(from, lowerBound(file));
+    }
+
+    reindex(from);
+    emit changed();
+}
+
+void DirIndex::reindex(int from)
+{
+    for(int i = from; i < m_files.size(); ++i) {
+        m_positions.insert(m_files[i], i);
+    }
+}
+
+int DirIndex::lowerBound(const QString &fileName) const
+{
+    return static_cast<int>(std::lower_bound(m_files.cbegin(), m_files.cend(), fileName, lessThan) - m_files.cbegin());
+}
+
+} // namespace pork
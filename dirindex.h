@@ -0,0 +1,73 @@
+#ifndef DIRINDEX_H
+#define DIRINDEX_H
+
+#include "utils.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QHash>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+namespace pork {
+
+//! Sorted list of supported files of a directory with O(1) position lookup.
+//! It is filled by batches streamed from a scanning thread, so it is usable before the listing completes.
+//! Then it is kept up to date by file system watcher. The watcher tells nothing about which files changed,
+//! so the directory is listed anew off the gui thread and the result is diffed against the index.
+class DirIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DirIndex(QObject *parent = 0);
+    ~DirIndex();
+
+    //! `seed` file is indexed right away, so navigation from it starts before the scanning finishes
+    void setPath(const QString &path, const QString &seed = QString());
+    const QString &path() const { return m_path; }
+    bool isLoading() const { return m_loading; }
+    qint64 scanTime() const { return m_loading ? m_scanTimer.elapsed() : m_scanTime; } //! of the last or the running scan. in ms
+
+    int size() const { return m_files.size(); }
+    bool isEmpty() const { return m_files.isEmpty(); }
+
+    const QString &at(int index) const { return m_files[index]; }
+    int indexOf(const QString &fileName) const;
+    QString filePath(const QString &fileName) const;
+    QString neighbour(const QString &fileName, Direction dir, int distance = 1) const;
+
+signals:
+    void changed();
+
+private:
+    void scan(bool refresh);
+    void merge();
+    void update();
+    void apply(const QStringList &files); //! `files` are sorted by `lessThan`
+    void reindex(int from);
+    int lowerBound(const QString &fileName) const;
+
+    QString m_path;
+    QStringList m_files; //! file names sorted by `lessThan`
+    QHash<QString, int> m_positions;
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_updateTimer;
+    QTimer m_mergeTimer;
+    QStringList m_incoming; //! scanned files waiting for the next merge
+
+    QThreadPool m_pool;
+    QAtomicInt m_generation {0}; //! scans of previous generations are abandoned
+    bool m_loading {false};
+    QElapsedTimer m_scanTimer;
+    qint64 m_scanTime {0};
+    bool m_outdated {false};     //! directory changed while it was scanned
+};
+
+} // namespace pork
+
+#endif // DIRINDEX_H
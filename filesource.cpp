@@ -0,0 +1,103 @@
+#include "filesource.h"
+
+#include <QBuffer>
+#include <QImageReader>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QWeakPointer>
+#include <iterator>
+#include <limits>
+
+namespace pork {
+
+namespace {
+
+QMutex registryMutex;
+QHash<QString, QWeakPointer<FileSource>> registry;
+
+} // namespace
+
+QSharedPointer<FileSource> FileSource::open(const QString &filePath)
+{
+    const QFileInfo info(filePath);
+    const QString path { info.absoluteFilePath() };
+
+    QMutexLocker lock(&registryMutex);
+    QSharedPointer<FileSource> source { registry.value(path).toStrongRef() };
+    if(source && source->m_size == info.size() && source->m_modified == info.lastModified()) {
+        return source;
+    }
+
+    source.reset(new FileSource(path));
+    registry.insert(path, source);
+
+    // forget released sources from time to time
+    if(registry.size() > 64) {
+        for(auto it = registry.begin(); it != registry.end();) {
+            it = it.value().isNull() ? registry.erase(it) : std::next(it);
+        }
+    }
+
+    return source;
+}
+
+FileSource::FileSource(const QString &filePath)
+    : m_path(filePath)
+    , m_file(filePath)
+{
+    if(!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return;
+    }
+
+    const QFileInfo info(m_file);
+    m_modified = info.lastModified();
+    m_size = m_file.size();
+
+    // byte arrays can't hold bigger files. readers go by path then
+    if(m_size > std::numeric_limits<int>::max()) {
+        return;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if(m_data) {
+        m_bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(m_data), static_cast<int>(m_size));
+    } else {
+        // some file systems can't be mapped. a single read is the next best thing
+        m_bytes = m_file.readAll();
+    }
+}
+
+FileSource::~FileSource()
+{
+    // raw data view must be gone before the mapping
+    m_bytes.clear();
+    if(m_data) {
+        m_file.unmap(m_data);
+    }
+}
+
+QByteArray FileSource::format() const
+{
+    return QFileInfo(m_path).suffix().toLower().toLatin1();
+}
+
+void FileSource::attach(QImageReader &reader, QBuffer &buffer) const
+{
+    if(!isMapped()) {
+        reader.setFileName(m_path);
+        return;
+    }
+
+    buffer.setData(m_bytes);
+    buffer.open(QIODevice::ReadOnly);
+    reader.setDevice(&buffer);
+
+    // content decides, so misnamed files get the right plugin. suffix is for formats without magic bytes
+    if(QImageReader::imageFormat(&buffer).isEmpty()) {
+        reader.setFormat(format());
+    }
+}
+
+} // namespace pork
@@ -0,0 +1,52 @@
+#ifndef FILESOURCE_H
+#define FILESOURCE_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QDateTime>
+#include <QSharedPointer>
+
+class QBuffer;
+class QImageReader;
+
+namespace pork {
+
+//! File mapped into memory once and shared by all of its readers: sniffing, size probes,
+//! decoders and thumbnailers get the same mapping while any of them holds the source.
+//! Readers go through `QBuffer`s over the mapping, so file data is neither read twice nor copied.
+class FileSource
+{
+public:
+    //! Returns already opened source of the file if it's still unchanged, otherwise maps it
+    static QSharedPointer<FileSource> open(const QString &filePath);
+    ~FileSource();
+
+    const QString &path() const { return m_path; }
+    const QDateTime &modified() const { return m_modified; }
+    const QString &errorString() const { return m_error; }
+    bool isValid() const { return m_error.isEmpty(); }
+    bool isMapped() const { return !m_bytes.isNull(); }
+
+    //! Raw data without copy. It must not outlive the source
+    const QByteArray &bytes() const { return m_bytes; }
+    QByteArray format() const;
+
+    //! Makes `reader` read from `buffer` opened over the mapping. Files which can't be mapped are read by path.
+    //! The source must outlive both of them
+    void attach(QImageReader &reader, QBuffer &buffer) const;
+
+private:
+    explicit FileSource(const QString &filePath);
+
+    QString m_path;
+    QFile m_file;
+    uchar *m_data {nullptr};
+    QByteArray m_bytes;
+    QDateTime m_modified;
+    qint64 m_size {0};
+    QString m_error;
+};
+
+} // namespace pork
+
+#endif // FILESOURCE_H
@@ -0,0 +1,223 @@
+#include "gridview.h"
+#include "config.h"
+#include "dirindex.h"
+#include "watchdog.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+
+namespace pork {
+
+GridView::GridView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    verticalScrollBar()->setSingleStep(tune::grid::cellSize/4);
+
+    m_thumbnailer.setSize(QSize(tune::grid::thumbSize, tune::grid::thumbSize));
+
+    connect(&m_thumbnailer, &Thumbnailer::ready, viewport(), QOverload<>::of(&QWidget::update));
+}
+
+void GridView::setIndex(DirIndex *index)
+{
+    if(m_index) {
+        m_index->disconnect(this);
+    }
+
+    m_index = index;
+    connect(m_index, &DirIndex::changed, this, [this]() {
+        updateLayout();
+        viewport()->update();
+    });
+
+    updateLayout();
+}
+
+void GridView::setCurrent(const QString &fileName)
+{
+    const int index { m_index ? m_index->indexOf(fileName) : -1 };
+    setCurrentIndex(qMax(index, 0));
+}
+
+void GridView::updateLayout()
+{
+    constexpr int cell { tune::grid::cellSize };
+
+    m_columns = qMax(viewport()->width()/cell, 1);
+    const int count { m_index ? m_index->size() : 0 };
+    const int rows { (count + m_columns - 1)/m_columns };
+
+    verticalScrollBar()->setRange(0, qMax(rows*cell - viewport()->height(), 0));
+    verticalScrollBar()->setPageStep(viewport()->height());
+
+    if(m_current >= count) {
+        m_current = qMax(count - 1, 0);
+    }
+}
+
+QRect GridView::cellRect(int index) const
+{
+    constexpr int cell { tune::grid::cellSize };
+
+    // cells are centered horizontally
+    const int left { (viewport()->width() - m_columns*cell)/2 };
+    const int x { left + index%m_columns*cell };
+    const int y { index/m_columns*cell - verticalScrollBar()->value() };
+    return QRect(x, y, cell, cell);
+}
+
+int GridView::indexAt(const QPoint &pos) const
+{
+    constexpr int cell { tune::grid::cellSize };
+
+    const int left { (viewport()->width() - m_columns*cell)/2 };
+    const int column { (pos.x() - left)/cell };
+    if(pos.x() < left || column >= m_columns) {
+        return -1;
+    }
+
+    const int index { (pos.y() + verticalScrollBar()->value())/cell*m_columns + column };
+    return m_index && index < m_index->size() ? index : -1;
+}
+
+void GridView::setCurrentIndex(int index)
+{
+    if(!m_index || m_index->isEmpty()) {
+        return;
+    }
+
+    m_current = qBound(0, index, m_index->size() - 1);
+
+    // keep current cell on the screen
+    const QRect rect { cellRect(m_current) };
+    QScrollBar *bar { verticalScrollBar() };
+    if(rect.top() < 0) {
+        bar->setValue(bar->value() + rect.top());
+    } else if(rect.bottom() > viewport()->height()) {
+        bar->setValue(bar->value() + rect.bottom() - viewport()->height());
+    }
+
+    viewport()->update();
+}
+
+void GridView::paintEvent(QPaintEvent *event)
+{
+    PORK_TRACE("GridView::paintEvent");
+    PORK_OPERATION("GridView::paintEvent");
+
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), QColor(tune::grid::background));
+
+    if(!m_index || m_index->isEmpty()) {
+        return;
+    }
+
+    constexpr int cell { tune::grid::cellSize };
+    constexpr int pad { tune::grid::pad };
+
+    const int scroll { verticalScrollBar()->value() };
+    const int visibleRows { viewport()->height()/cell + 2 };
+    const int first { qMin(scroll/cell*m_columns, m_index->size()) };
+    const int last { qMin(first + visibleRows*m_columns, m_index->size()) };
+
+    // the latest requested thumbnails are made first: the next screen goes before the visible one
+    const int ahead { qMin(last + visibleRows*m_columns, m_index->size()) };
+    for(int i = ahead - 1; i >= last; --i) {
+        m_thumbnailer.thumbnail(m_index->filePath(m_index->at(i)));
+    }
+
+    const int text { fontMetrics().height() };
+    painter.setPen(QColor(tune::grid::textColor));
+
+    // backwards, so that the top left thumbnails are requested last and made first
+    for(int i = last - 1; i >= first; --i) {
+        const QRect rect { cellRect(i) };
+        if(!rect.intersects(event->rect())) {
+            continue;
+        }
+
+        const QString &file { m_index->at(i) };
+        const QRect thumbRect { rect.adjusted(pad, pad, -pad, -pad - text) };
+        const QImage thumb { m_thumbnailer.thumbnail(m_index->filePath(file)) };
+
+        if(thumb.isNull()) {
+            painter.fillRect(thumbRect.adjusted(pad, pad, -pad, -pad), QColor(tune::grid::placeholderColor));
+        } else {
+            QRect target { QPoint(), thumb.size() };
+            target.moveCenter(thumbRect.center());
+            painter.drawImage(target, thumb);
+        }
+
+        const QRect textRect { thumbRect.left(), thumbRect.bottom(), thumbRect.width(), text };
+        painter.drawText(textRect, Qt::AlignCenter, fontMetrics().elidedText(file, Qt::ElideMiddle, textRect.width()));
+
+        if(i == m_current) {
+            painter.save();
+            painter.setPen(QPen(QColor(tune::grid::currentColor), 2));
+            painter.drawRect(rect.adjusted(1, 1, -1, -1));
+            painter.restore();
+        }
+    }
+}
+
+void GridView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateLayout();
+}
+
+void GridView::keyPressEvent(QKeyEvent *event)
+{
+    const int page { qMax(viewport()->height()/tune::grid::cellSize, 1)*m_columns };
+
+    switch(event->key()) {
+        case Qt::Key_Left:     setCurrentIndex(m_current - 1); return;
+        case Qt::Key_Right:    setCurrentIndex(m_current + 1); return;
+        case Qt::Key_Up:       setCurrentIndex(m_current - m_columns); return;
+        case Qt::Key_Down:     setCurrentIndex(m_current + m_columns); return;
+        case Qt::Key_PageUp:   setCurrentIndex(m_current - page); return;
+        case Qt::Key_PageDown: setCurrentIndex(m_current + page); return;
+        case Qt::Key_Home:     setCurrentIndex(0); return;
+        case Qt::Key_End:      setCurrentIndex(m_index ? m_index->size() - 1 : 0); return;
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+            if(m_index && !m_index->isEmpty()) {
+                emit activated(m_index->at(m_current));
+            }
+            return;
+        case Qt::Key_G:
+        case Qt::Key_Escape:   emit closeRequested(); return;
+        default: break;
+    }
+
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void GridView::mousePressEvent(QMouseEvent *event)
+{
+    // clicks must not reach main window, it treats them as navigation
+    const int index { indexAt(event->pos()) };
+    if(index >= 0) {
+        setCurrentIndex(index);
+    }
+    event->accept();
+}
+
+void GridView::mouseReleaseEvent(QMouseEvent *event)
+{
+    event->accept();
+}
+
+void GridView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    const int index { indexAt(event->pos()) };
+    if(index >= 0) {
+        emit activated(m_index->at(index));
+    }
+    event->accept();
+}
+
+} // namespace pork
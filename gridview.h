@@ -0,0 +1,50 @@
+#ifndef GRIDVIEW_H
+#define GRIDVIEW_H
+
+#include "thumbnailer.h"
+
+#include <QAbstractScrollArea>
+
+namespace pork {
+
+class DirIndex;
+
+//! Contact sheet of a directory. Only visible cells are painted and only their thumbnails
+//! (plus a screen ahead) are requested, so directory size does not matter for scrolling.
+class GridView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit GridView(QWidget *parent = 0);
+
+    void setIndex(DirIndex *index);
+    void setCurrent(const QString &fileName);
+
+signals:
+    void activated(const QString &fileName);
+    void closeRequested();
+
+protected:
+    virtual void paintEvent(QPaintEvent *event) override;
+    virtual void resizeEvent(QResizeEvent *event) override;
+    virtual void keyPressEvent(QKeyEvent *event) override;
+    virtual void mousePressEvent(QMouseEvent *event) override;
+    virtual void mouseReleaseEvent(QMouseEvent *event) override;
+    virtual void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    void updateLayout();
+    int indexAt(const QPoint &pos) const;
+    QRect cellRect(int index) const;
+    void setCurrentIndex(int index);
+
+    DirIndex *m_index {nullptr};
+    Thumbnailer m_thumbnailer;
+    int m_columns {1};
+    int m_current {0};
+};
+
+} // namespace pork
+
+#endif // GRIDVIEW_H
@@ -0,0 +1,342 @@
+#include "imagecache.h"
+#include "config.h"
+#include "previewstore.h"
+#include "filesource.h"
+#include "classifier.h"
+#include "trace.h"
+
+#include <QImageReader>
+#include <QBuffer>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+namespace pork {
+
+ImageCache::ImageCache(QObject *parent)
+    : QObject(parent)
+{
+    // one thread more than prefetch may occupy, so requested file never waits for neighbours
+    m_pool.setMaxThreadCount(tune::prefetch::threads + 1);
+    m_cache.setMaxCost(tune::prefetch::memoryCap*1024);
+}
+
+ImageCache::~ImageCache()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        for(auto &job : m_queue) {
+            job.result.reportCanceled();
+            job.result.reportFinished();
+        }
+        m_queue.clear();
+    }
+    m_pool.waitForDone();
+}
+
+QFuture<DecodedImage> ImageCache::request(const QString &file, bool full)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        for(auto it = m_queue.begin(); it != m_queue.end();) {
+            if(it->file == file) {
+                ++it;
+            } else if(it->full) {
+                // stale full resolution decode would hold a worker ahead of the neighbours
+                cancel(*it);
+                it = m_queue.erase(it);
+            } else {
+                // user has moved past files requested before. let them wait for neighbours
+                it->prefetch = true;
+                ++it;
+            }
+        }
+    }
+
+    // decoding in progress is not a hit yet
+    if(m_pending.contains(Key(file, full))) {
+        ++m_misses;
+        return enqueue(file, full, false);
+    }
+
+    DecodedImage *cached { m_cache.object(file) };
+    if(cached && (cached->isFull() || !full) && cached->modified == QFileInfo(file).lastModified()) {
+        ++m_hits;
+        DecodedImage res { *cached };
+        res.origin = DecodedImage::Cache;
+
+        QFutureInterface<DecodedImage> result;
+        result.reportStarted();
+        result.reportResult(res);
+        result.reportFinished();
+        return result.future();
+    }
+
+    // preview made by one of the previous runs is shown right away
+    if(!full) {
+        DecodedImage stored;
+        if(fromStore(file, stored)) {
+            ++m_hits;
+            insert(stored);
+
+            QFutureInterface<DecodedImage> result;
+            result.reportStarted();
+            result.reportResult(stored);
+            result.reportFinished();
+            return result.future();
+        }
+    }
+
+    ++m_misses;
+    return enqueue(file, full, false);
+}
+
+bool ImageCache::fromStore(const QString &file, DecodedImage &decoded) const
+{
+    const QFileInfo info(file);
+    QSize fullSize;
+    const QImage image { PreviewStore::instance().find(info, m_fitSize, &fullSize) };
+    if(image.isNull()) {
+        return false;
+    }
+
+    decoded.file = file;
+    decoded.image = image;
+    decoded.modified = info.lastModified();
+    decoded.fullSize = fullSize;
+    decoded.origin = DecodedImage::Store;
+    return true;
+}
+
+void ImageCache::prefetch(const QStringList &files)
+{
+    {
+        // neighbours of the previous files are of no interest anymore
+        QMutexLocker lock(&m_mutex);
+        for(auto it = m_queue.begin(); it != m_queue.end();) {
+            if(it->prefetch && !files.contains(it->file)) {
+                cancel(*it);
+                it = m_queue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for(const auto &file : files) {
+        if(!m_cache.contains(file)) {
+            enqueue(file, false, true);
+        }
+    }
+}
+
+QFuture<DecodedImage> ImageCache::enqueue(const QString &file, bool full, bool prefetch)
+{
+    QMutexLocker lock(&m_mutex);
+
+    const Key key { file, full };
+    auto pending { m_pending.find(key) };
+    if(pending != m_pending.end() && pending.value()->isCanceled()) {
+        // canceled future would never deliver. the file is decoded anew
+        m_pending.erase(pending);
+        pending = m_pending.end();
+    }
+    if(pending != m_pending.end()) {
+        if(!prefetch) {
+            // raise queued prefetch job to the front
+            for(int i = 0; i < m_queue.size(); ++i) {
+                if(m_queue[i].file == file && m_queue[i].full == full) {
+                    Job job { m_queue.takeAt(i) };
+                    job.prefetch = false;
+                    m_queue.prepend(job);
+                    break;
+                }
+            }
+        }
+        return pending.value()->future();
+    }
+
+    Job job { file, full, QFutureInterface<DecodedImage>(), prefetch };
+    job.result.reportStarted();
+    if(prefetch) {
+        m_queue.append(job);
+    } else {
+        m_queue.prepend(job);
+    }
+
+    auto watcher { new QFutureWatcher<DecodedImage>(this) };
+    connect(watcher, &QFutureWatcher<DecodedImage>::finished, this, [this, key, watcher]() {
+        // the key may belong to a newer job of the same file already
+        if(m_pending.value(key) == watcher) {
+            m_pending.remove(key);
+        }
+        if(!watcher->isCanceled() && watcher->future().resultCount()) {
+            insert(watcher->result());
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(job.result.future());
+    m_pending.insert(key, watcher);
+
+    if(m_workers < m_pool.maxThreadCount()) {
+        ++m_workers;
+        QtConcurrent::run(&m_pool, [this]() { work(); });
+    }
+
+    return job.result.future();
+}
+
+void ImageCache::cancel(Job &job)
+{
+    job.result.reportCanceled();
+    job.result.reportFinished();
+
+    // next request of the file must not get the canceled future
+    m_pending.remove(Key(job.file, job.full));
+}
+
+bool ImageCache::takeJob(Job &job)
+{
+    for(int i = 0; i < m_queue.size(); ++i) {
+        if(!m_queue[i].prefetch) {
+            job = m_queue.takeAt(i);
+            return true;
+        }
+    }
+
+    if(m_queue.isEmpty() || m_prefetching >= tune::prefetch::threads) {
+        return false;
+    }
+
+    ++m_prefetching;
+    job = m_queue.takeFirst();
+    return true;
+}
+
+void ImageCache::work()
+{
+    forever {
+        Job job;
+        {
+            QMutexLocker lock(&m_mutex);
+            if(!takeJob(job)) {
+                --m_workers;
+                return;
+            }
+        }
+
+        DecodedImage decoded;
+        if(job.full) {
+            decoded = decode(job.file, QSize(), true);
+        } else if(!fromStore(job.file, decoded)) {
+            decoded = decode(job.file, m_fitSize, true);
+
+            // tiled pictures need their source anyway, storing their overviews is pointless
+            if(!decoded.tiled) {
+                PreviewStore::instance().insert(QFileInfo(job.file), m_fitSize, decoded.image, decoded.fullSize);
+            }
+        }
+
+        job.result.reportResult(decoded);
+        job.result.reportFinished();
+
+        if(job.prefetch) {
+            QMutexLocker lock(&m_mutex);
+            --m_prefetching;
+        }
+    }
+}
+
+void ImageCache::insert(const DecodedImage &decoded)
+{
+    if(decoded.image.isNull()) {
+        return;
+    }
+
+    // fitted picture must not replace already decoded full resolution one
+    DecodedImage *cached { m_cache.object(decoded.file) };
+    if(cached && cached->isFull() && !decoded.isFull() && cached->modified == decoded.modified) {
+        return;
+    }
+
+    // cost is in KB to stay far from `int` limits
+    const int cost { static_cast<int>(decoded.image.sizeInBytes()/1024) };
+    m_cache.insert(decoded.file, new DecodedImage(decoded), cost);
+}
+
+DecodedImage ImageCache::decode(const QString &file, const QSize &fitSize, bool probeAnimations)
+{
+    PORK_TRACE("ImageCache::decode");
+
+    DecodedImage res;
+    res.file = file;
+
+    // opened here on the worker and released with the result, so the shown file is not held open
+    const QSharedPointer<FileSource> source { FileSource::open(file) };
+    if(!source->isValid()) {
+        res.error = source->errorString();
+        return res;
+    }
+    res.modified = source->modified();
+
+    // static gifs and webps are cheaper as pictures, misnamed files go where their content belongs
+    if(probeAnimations) {
+        MediaMode mode { MediaMode::Image };
+        classify(file, mode);
+        const Content content { sniff(*source) };
+        res.animated = content == Content::Animation || (content == Content::Unknown && mode == MediaMode::Gif);
+    }
+
+    QBuffer buffer;
+    QImageReader reader;
+    source->attach(reader, buffer);
+    reader.setAutoTransform(true);
+
+    // scaled size is applied before auto transformation, so rotated pictures are fitted transposed
+    const bool transposed { static_cast<bool>(reader.transformation() & QImageIOHandler::TransformationRotate90) };
+    QSize size { reader.size() };
+    if(transposed) {
+        size.transpose();
+    }
+
+    // animations are decoded by `AnimationPlayer` at the current scale. only the size is needed
+    if(res.animated) {
+        res.fullSize = size;
+        return res;
+    }
+
+    // huge pictures are never decoded at full resolution. overview only
+    QSize fit { fitSize };
+    res.tiled = static_cast<qint64>(size.width())*size.height() > tune::tiled::threshold;
+    if(res.tiled && !fit.isValid()) {
+        fit = QSize(tune::tiled::overviewSize, tune::tiled::overviewSize);
+    }
+
+    if(fit.isValid() && size.isValid() && (size.width() > fit.width() || size.height() > fit.height())) {
+        // jpeg decoder scales in DCT domain, others are still cheaper to scale once here than on every paint
+        QSize scaled { size.scaled(fit, Qt::KeepAspectRatio) };
+        if(transposed) {
+            scaled.transpose();
+        }
+        reader.setScaledSize(scaled);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QImage image { reader.read() };
+    res.decodeTime = timer.nsecsElapsed()/1000;
+
+    // converted here on the worker, so neither gui thread nor painting converts it again
+    timer.restart();
+    PORK_TRACE("toDisplayFormat");
+    res.image = toDisplayFormat(image, tune::decode::reduceDeepColor);
+    res.convertTime = timer.nsecsElapsed()/1000;
+    if(res.image.isNull()) {
+        res.error = reader.errorString();
+    }
+    res.fullSize = size.isValid() ? size : res.image.size();
+
+    return res;
+}
+
+} // namespace pork
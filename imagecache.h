@@ -0,0 +1,94 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QObject>
+#include <QImage>
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QDateTime>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QFutureInterface>
+
+namespace pork {
+
+struct DecodedImage
+{
+    enum Origin { Decoder, Store, Cache }; //! where the picture was taken from
+
+    QString file;
+    QImage image;
+    QString error;
+    QDateTime modified;
+    QSize fullSize; //! size of the picture at full resolution. `image` may be decoded smaller
+    bool tiled {false}; //! picture is too big, `image` is its overview. see `TiledImage`
+    bool animated {false}; //! content is an animation, `image` is null. see `AnimationPlayer`
+    Origin origin {Decoder};
+    qint64 decodeTime {0};  //! in us
+    qint64 convertTime {0}; //! conversion to display format. in us
+
+    bool isFull() const { return image.size() == fullSize; }
+};
+
+//! Memory capped LRU cache of decoded images.
+//! All decoding happens on worker threads: files requested for display go first,
+//! neighbour files are decoded in advance so navigation doesn't wait for decoder.
+//! Pictures are decoded just big enough to fit the screen unless full resolution is requested.
+//! Such fitted previews are kept in `PreviewStore` across runs.
+class ImageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageCache(QObject *parent = 0);
+    ~ImageCache();
+
+    void setFitSize(const QSize &size) { m_fitSize = size; }
+
+    QFuture<DecodedImage> request(const QString &file, bool full = false);
+    void prefetch(const QStringList &files);
+
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+    int memoryUsed() const { return m_cache.totalCost(); } //! in KB
+
+    //! With `probeAnimations` animated content is only sniffed and sized, its pixels are left to `AnimationPlayer`
+    static DecodedImage decode(const QString &file, const QSize &fitSize = QSize(), bool probeAnimations = false);
+
+private:
+    struct Job
+    {
+        QString file;
+        bool full;
+        QFutureInterface<DecodedImage> result;
+        bool prefetch;
+    };
+    using Key = QPair<QString, bool>; //! file and full resolution flag
+
+    QFuture<DecodedImage> enqueue(const QString &file, bool full, bool prefetch);
+    void cancel(Job &job); //! of a queued job. `m_mutex` must be locked
+    bool takeJob(Job &job);
+    bool fromStore(const QString &file, DecodedImage &decoded) const;
+    void work();
+    void insert(const DecodedImage &decoded);
+
+    QThreadPool m_pool;
+    QSize m_fitSize;
+    QCache<QString, DecodedImage> m_cache;
+    QHash<Key, QFutureWatcher<DecodedImage>*> m_pending;
+
+    QMutex m_mutex;
+    QList<Job> m_queue; //! requested files go first, then prefetched ones
+    int m_workers {0};
+    int m_prefetching {0};
+
+    int m_hits {0};
+    int m_misses {0};
+};
+
+} // namespace pork
+
+#endif // IMAGECACHE_H
@@ -0,0 +1,252 @@
+#include "imageview.h"
+#include "config.h"
+#include "tiledimage.h"
+#include "resampler.h"
+#include "watchdog.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+namespace pork {
+
+static QVector<QImage> buildMipmaps(const QImage &image)
+{
+    QVector<QImage> levels { image };
+    while(levels.last().width() >= 2*tune::view::mipmapMinSize && levels.last().height() >= 2*tune::view::mipmapMinSize) {
+        const QImage &prev { levels.last() };
+        levels << resample(prev, QSize(prev.width()/2, prev.height()/2), ResampleFilter::Area);
+    }
+    return levels;
+}
+
+ImageView::ImageView(QWidget *parent)
+    : QWidget(parent)
+{
+    connect(&m_mipmapsWatcher, &QFutureWatcher<QVector<QImage>>::finished, this, [this]() {
+        // picture may have changed while pyramid was built
+        const QVector<QImage> levels { m_mipmapsWatcher.result() };
+        if(levels.first().cacheKey() != m_image.cacheKey()) {
+            return;
+        }
+
+        m_mipmaps = levels;
+        m_tiles.clear();
+        update();
+    });
+
+    const QSize screenSize { pork::screen().size() };
+    m_tiles.setMaxCost(screenSize.width()*screenSize.height()*4/1024*tune::view::tileCacheScreens);
+}
+
+void ImageView::setImage(const QImage &image, const QSharedPointer<TiledImage> &tiled)
+{
+    if(m_tiled) {
+        m_tiled->disconnect(this);
+    }
+
+    // resampler works with display format directly. decoders deliver it already, except for deep color kept by `tune::decode`
+    m_image = toDisplayFormat(image);
+    m_tiled = tiled;
+    m_tiles.clear();
+    m_mipmaps.clear();
+
+    if(!m_image.isNull()) {
+        m_mipmapsWatcher.setFuture(QtConcurrent::run(buildMipmaps, m_image));
+    }
+
+    if(m_tiled) {
+        connect(m_tiled.data(), &TiledImage::tileReady, this, static_cast<void (QWidget::*)()>(&QWidget::update));
+    }
+
+    updateGeometry();
+    update();
+}
+
+void ImageView::setScale(qreal scale)
+{
+    if(qFuzzyCompare(scale, m_scale)) {
+        return;
+    }
+
+    m_scale = scale;
+    updateGeometry();
+    update();
+}
+
+void ImageView::setSmooth(bool smooth)
+{
+    if(smooth == m_smooth) {
+        return;
+    }
+
+    m_smooth = smooth;
+    update();
+}
+
+void ImageView::clear()
+{
+    setImage(QImage());
+}
+
+QSize ImageView::displaySize() const
+{
+    return m_image.isNull() ? QSize() : m_image.size()*m_scale;
+}
+
+QSize ImageView::sizeHint() const
+{
+    return displaySize();
+}
+
+QSize ImageView::minimumSizeHint() const
+{
+    return displaySize();
+}
+
+QPoint ImageView::offset() const
+{
+    // picture is centered when it's smaller than the widget
+    const QSize diff { (size() - displaySize())/2 };
+    return QPoint { std::max(diff.width(), 0), std::max(diff.height(), 0) };
+}
+
+void ImageView::paintEvent(QPaintEvent *event)
+{
+    if(m_image.isNull()) {
+        return;
+    }
+
+    const QPoint origin { offset() };
+    const QRect visible { event->rect().translated(-origin) & QRect(QPoint(), displaySize()) };
+    if(visible.isEmpty()) {
+        return;
+    }
+
+    PORK_TRACE("ImageView::paintEvent");
+    PORK_OPERATION("ImageView::paintEvent");
+    QElapsedTimer timer;
+    timer.start();
+    m_paintStats = PaintStats();
+
+    QPainter painter(this);
+
+    if(!m_smooth) {
+        const QImage &level { mipmap() };
+        const qreal scale { m_scale*m_image.width()/level.width() };
+        const QRect source { QRectF(visible.x()/scale, visible.y()/scale, visible.width()/scale, visible.height()/scale).toAlignedRect()
+                             & level.rect() };
+
+        painter.translate(origin);
+        painter.scale(scale, scale);
+        painter.drawImage(source.topLeft(), level, source);
+        m_paintStats.total = timer.nsecsElapsed()/1000;
+        emit painted();
+        return;
+    }
+
+    constexpr int tileSize { tune::view::tileSize };
+    for(int y = visible.top()/tileSize; y <= visible.bottom()/tileSize; ++y) {
+        for(int x = visible.left()/tileSize; x <= visible.right()/tileSize; ++x) {
+            painter.drawPixmap(origin + QPoint(x*tileSize, y*tileSize), tile(x, y));
+        }
+    }
+    m_paintStats.total = timer.nsecsElapsed()/1000;
+    emit painted();
+}
+
+QPixmap ImageView::tile(int x, int y)
+{
+    constexpr int tileSize { tune::view::tileSize };
+
+    // tiles of different scales live together, so zooming back finds them ready
+    const quint64 scaleKey { static_cast<quint64>(qRound(m_scale*10000)) };
+    const quint64 key { scaleKey << 40 | static_cast<quint64>(y) << 20 | static_cast<quint64>(x) };
+    ++m_paintStats.tiles;
+    if(QPixmap *cached = m_tiles.object(key)) {
+        ++m_paintStats.cachedTiles;
+        return *cached;
+    }
+
+    PORK_TRACE("ImageView::tile");
+    QElapsedTimer timer;
+    timer.start();
+
+    const QRect rect { QRect(x*tileSize, y*tileSize, tileSize, tileSize) & QRect(QPoint(), displaySize()) };
+
+    // resample from the nearest larger mipmap level, so cost doesn't depend on the picture size
+    const QImage &level { mipmap() };
+    const qreal scale { m_scale*m_image.width()/level.width() };
+
+    // exact source area of the tile. resampler takes neighbour pixels itself, so tiles have no seams
+    const QRectF source { rect.x()/scale, rect.y()/scale, rect.width()/scale, rect.height()/scale };
+    QImage image { qFuzzyCompare(scale, 1.0) ? level.copy(rect) : resample(level, source, rect.size()) };
+
+    bool complete {true};
+
+    // zoomed past the overview of a huge picture. detailed regions go over it once decoded
+    if(m_tiled && m_scale > 1.0) {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.translate(-rect.topLeft());
+        complete = drawRegions(painter, rect);
+    }
+
+    m_paintStats.resample += timer.nsecsElapsed()/1000;
+
+    timer.restart();
+    const QPixmap res { QPixmap::fromImage(image) };
+    m_paintStats.upload += timer.nsecsElapsed()/1000;
+    if(complete) {
+        m_tiles.insert(key, new QPixmap(res), image.width()*image.height()*4/1024 + 1);
+    }
+    return res;
+}
+
+int ImageView::memoryUsed() const
+{
+    qint64 bytes {0};
+    for(int i = 1; i < m_mipmaps.size(); ++i) {
+        bytes += m_mipmaps[i].sizeInBytes();
+    }
+    return static_cast<int>(bytes/1024) + m_tiles.totalCost();
+}
+
+const QImage &ImageView::mipmap() const
+{
+    int level {0};
+    while(level + 1 < m_mipmaps.size() && m_scale*(1 << (level + 1)) <= 1.0) {
+        ++level;
+    }
+    return level == 0 ? m_image : m_mipmaps[level];
+}
+
+bool ImageView::drawRegions(QPainter &painter, const QRect &rect)
+{
+    // scale relative to the full resolution
+    const qreal scale { m_scale*m_image.width()/m_tiled->fullSize().width() };
+    const int level { TiledImage::levelFor(scale) };
+    const int side { tune::tiled::tileSize << level };
+
+    const QRect source { QRectF(rect.x()/scale, rect.y()/scale, rect.width()/scale, rect.height()/scale).toAlignedRect()
+                         & QRect(QPoint(), m_tiled->fullSize()) };
+
+    bool complete {true};
+
+    painter.scale(scale*(1 << level), scale*(1 << level));
+    for(int y = source.top()/side; y <= source.bottom()/side; ++y) {
+        for(int x = source.left()/side; x <= source.right()/side; ++x) {
+            const QImage region { m_tiled->tile(level, x, y) };
+            if(region.isNull()) {
+                complete = false;
+                continue;
+            }
+            painter.drawImage(QPoint(x, y)*tune::tiled::tileSize, region);
+        }
+    }
+
+    return complete;
+}
+
+} // namespace pork
@@ -0,0 +1,75 @@
+#ifndef IMAGEVIEW_H
+#define IMAGEVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QPixmap>
+#include <QCache>
+#include <QSharedPointer>
+#include <QVector>
+#include <QFutureWatcher>
+
+namespace pork {
+
+class TiledImage;
+
+//! Paints only the visible part of a picture at the current scale.
+//! Scaled tiles are cached, so memory use is bounded by screen size rather than by zoom level.
+//! Every zoom step resamples from the nearest larger level of mipmap pyramid built in background.
+//! Huge pictures are shown as an overview image, detailed by `TiledImage` regions when zoomed in.
+class ImageView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    //! what the last paint took. in us
+    struct PaintStats
+    {
+        qint64 total {0};
+        qint64 resample {0};
+        qint64 upload {0}; //! `QPixmap` conversion of new tiles
+        int tiles {0};
+        int cachedTiles {0};
+    };
+
+    explicit ImageView(QWidget *parent = 0);
+
+    void setImage(const QImage &image, const QSharedPointer<TiledImage> &tiled = {});
+    void setScale(qreal scale);
+    void setSmooth(bool smooth);
+    void clear();
+
+    const QImage &image() const { return m_image; }
+    qreal scale() const { return m_scale; }
+    QSize displaySize() const;
+    QPoint offset() const;
+    const PaintStats &paintStats() const { return m_paintStats; }
+    int memoryUsed() const; //! tiles and mipmaps, the picture itself is not counted. in KB
+
+    virtual QSize sizeHint() const override;
+    virtual QSize minimumSizeHint() const override;
+
+signals:
+    void painted();
+
+protected:
+    virtual void paintEvent(QPaintEvent *event) override;
+
+private:
+    QPixmap tile(int x, int y);
+    const QImage &mipmap() const;
+    bool drawRegions(QPainter &painter, const QRect &rect);
+
+    QImage m_image;
+    QSharedPointer<TiledImage> m_tiled;
+    QVector<QImage> m_mipmaps; //! 1/2^n downscaled copies of `m_image`. `m_mipmaps[0]` is `m_image` itself
+    QFutureWatcher<QVector<QImage>> m_mipmapsWatcher;
+    qreal m_scale {1.0};
+    bool m_smooth {true}; //! fast unfiltered painting is used while zoom gesture is in progress
+    QCache<quint64, QPixmap> m_tiles;
+    PaintStats m_paintStats;
+};
+
+} // namespace pork
+
+#endif // IMAGEVIEW_H
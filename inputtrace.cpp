@@ -0,0 +1,270 @@
+#include "inputtrace.h"
+#include "mainwindow.h"
+#include "config.h"
+
+#include <QApplication>
+#include <QKeyEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QMap>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace pork {
+
+InputRecorder::InputRecorder(MainWindow *window, const QString &path)
+    : QObject(window)
+    , m_window(window)
+    , m_file(path)
+{
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qDebug() << "cannot record input to" << path << m_file.errorString();
+        return;
+    }
+
+    m_clock.start();
+    window->installEventFilter(this);
+}
+
+bool InputRecorder::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_UNUSED(watched)
+
+    // nothing to navigate or zoom without a file
+    const QString file { m_window->currentFile().absoluteFilePath() };
+    if(file.isEmpty()) {
+        return false;
+    }
+
+    QJsonObject record;
+    const QEvent::Type type { event->type() };
+    switch(type) {
+        case QEvent::KeyPress: {
+            const QKeyEvent *keyEvent { static_cast<QKeyEvent *>(event) };
+            record["key"] = keyEvent->key();
+            record["modifiers"] = static_cast<int>(keyEvent->modifiers());
+        } break;
+
+        case QEvent::Wheel: {
+            const QWheelEvent *wheelEvent { static_cast<QWheelEvent *>(event) };
+            record["delta"] = wheelEvent->delta();
+            record["x"] = wheelEvent->posF().x()/m_window->width();
+            record["y"] = wheelEvent->posF().y()/m_window->height();
+        } break;
+
+        case QEvent::MouseMove:
+            // hovering only shows video sliders
+            if(!(static_cast<QMouseEvent *>(event)->buttons() & Qt::LeftButton)) {
+                return false;
+            }
+            Q_FALLTHROUGH();
+
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease: {
+            const QMouseEvent *mouseEvent { static_cast<QMouseEvent *>(event) };
+            // screen of the replay may differ. clicks are treated by screen sections anyway
+            record["x"] = mouseEvent->localPos().x()/m_window->width();
+            record["y"] = mouseEvent->localPos().y()/m_window->height();
+            record["button"] = static_cast<int>(mouseEvent->button());
+            record["buttons"] = static_cast<int>(mouseEvent->buttons());
+        } break;
+
+        default: return false;
+    }
+
+    record["time"] = m_clock.elapsed();
+    record["type"] = static_cast<int>(type);
+    record["file"] = file;
+    m_file.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n');
+    m_file.flush();
+
+    return false;
+}
+
+namespace {
+
+struct Input
+{
+    qint64 time;
+    QString file;
+    QJsonObject record;
+};
+
+QVector<Input> readInput(const QString &path)
+{
+    QVector<Input> res;
+
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "cannot read input" << path << file.errorString();
+        return res;
+    }
+
+    while(!file.atEnd()) {
+        const QJsonObject record { QJsonDocument::fromJson(file.readLine()).object() };
+        if(!record.isEmpty()) {
+            res << Input { static_cast<qint64>(record["time"].toDouble()), record["file"].toString(), record };
+        }
+    }
+    return res;
+}
+
+void dispatch(MainWindow &window, const QJsonObject &record)
+{
+    const QEvent::Type type { static_cast<QEvent::Type>(record["type"].toInt()) };
+    const QPointF pos { record["x"].toDouble()*window.width(), record["y"].toDouble()*window.height() };
+    const QPointF globalPos { window.mapToGlobal(pos.toPoint()) };
+    const Qt::KeyboardModifiers modifiers { record["modifiers"].toInt() };
+
+    switch(type) {
+        case QEvent::KeyPress: {
+            QKeyEvent event(type, record["key"].toInt(), modifiers);
+            QApplication::sendEvent(&window, &event);
+        } break;
+
+        case QEvent::Wheel: {
+            const int delta { record["delta"].toInt() };
+            QWheelEvent event(pos, globalPos, QPoint(), QPoint(0, delta), delta, Qt::Vertical, Qt::NoButton, modifiers);
+            QApplication::sendEvent(&window, &event);
+        } break;
+
+        default: {
+            QMouseEvent event(type, pos, globalPos, static_cast<Qt::MouseButton>(record["button"].toInt()),
+                              Qt::MouseButtons(record["buttons"].toInt()), modifiers);
+            QApplication::sendEvent(&window, &event);
+        } break;
+    }
+}
+
+//! Waits for the frame showing the result of the input. Returns false if nothing was shown
+bool waitFrame(MainWindow &window)
+{
+    QEventLoop loop;
+    bool shown {false};
+
+    QMetaObject::Connection connection { QObject::connect(&window, &MainWindow::frameShown, &loop, [&]() {
+        if(window.isSettled()) {
+            shown = true;
+            loop.quit();
+        }
+    }) };
+
+    // input that changed nothing shows no frame. settled window is given one more check for late paints
+    int settledChecks {0};
+    QTimer idle;
+    idle.setInterval(tune::replay::idleTime);
+    QObject::connect(&idle, &QTimer::timeout, &loop, [&]() {
+        settledChecks = window.isSettled() ? settledChecks + 1 : 0;
+        if(settledChecks > 1) {
+            loop.quit();
+        }
+    });
+    idle.start();
+    QTimer::singleShot(tune::replay::timeout, &loop, &QEventLoop::quit);
+
+    loop.exec();
+    QObject::disconnect(connection);
+    return shown;
+}
+
+void wait(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+qreal percentile(const QVector<qreal> &sorted, qreal p)
+{
+    const int rank { static_cast<int>(std::ceil(p*sorted.size())) };
+    return sorted[qBound(0, rank - 1, sorted.size() - 1)];
+}
+
+} // namespace
+
+int replayInput(const QString &path)
+{
+    const QVector<Input> input { readInput(path) };
+    if(input.isEmpty()) {
+        qWarning() << "no input to replay in" << path;
+        return 1;
+    }
+
+    MainWindow window;
+    window.show();
+    if(!window.openFile(input.first().file)) {
+        qWarning() << "cannot open" << input.first().file;
+        return 1;
+    }
+    waitFrame(window);
+
+    QMap<QString, QVector<qreal>> latencies;
+    QMap<QString, int> missed;
+
+    // recorded pauses are kept, prefetching gets the same time as it had for the user
+    QElapsedTimer clock;
+    clock.start();
+    const qint64 origin { input.first().time };
+
+    for(const Input &event : input) {
+        const qint64 pause { event.time - origin - clock.elapsed() };
+        if(pause > 0) {
+            wait(static_cast<int>(pause));
+        }
+
+        // files opened by drop or by another instance are not input of the window. so are directory changes
+        if(window.currentFile().absoluteFilePath() != event.file) {
+            qDebug() << "replay diverged, reopening" << event.file;
+            window.openFile(event.file);
+            waitFrame(window);
+        }
+
+        const QString file { window.currentFile().absoluteFilePath() };
+        const qreal scale { window.scale() };
+
+        QElapsedTimer latency;
+        latency.start();
+        dispatch(window, event.record);
+        const bool shown { waitFrame(window) };
+        const qreal ms { latency.nsecsElapsed()/1000000.0 };
+
+        QString kind;
+        if(window.currentFile().absoluteFilePath() != file) {
+            kind = "navigation";
+        } else if(!qFuzzyCompare(window.scale(), scale)) {
+            kind = "zoom";
+        } else {
+            continue;
+        }
+
+        if(shown) {
+            latencies[kind] << ms;
+        } else {
+            ++missed[kind];
+        }
+    }
+
+    QTextStream out(stdout);
+    out << "kind,count,missed,p50_ms,p95_ms,p99_ms\n";
+    for(const QString &kind : {QStringLiteral("navigation"), QStringLiteral("zoom")}) {
+        QVector<qreal> sorted { latencies.value(kind) };
+        std::sort(sorted.begin(), sorted.end());
+
+        out << kind << ',' << sorted.size() << ',' << missed.value(kind);
+        if(sorted.isEmpty()) {
+            out << ",,,\n";
+        } else {
+            out << ',' << percentile(sorted, 0.5) << ',' << percentile(sorted, 0.95) << ',' << percentile(sorted, 0.99) << '\n';
+        }
+    }
+
+    return 0;
+}
+
+} // namespace pork
@@ -0,0 +1,33 @@
+#ifndef INPUTTRACE_H
+#define INPUTTRACE_H
+
+#include <QObject>
+#include <QFile>
+#include <QElapsedTimer>
+
+namespace pork {
+
+class MainWindow;
+
+//! Writes key, wheel and mouse input of the window to a file, one JSON object per line,
+//! together with its time and the file shown at that moment. See `replayInput`
+class InputRecorder : public QObject
+{
+public:
+    InputRecorder(MainWindow *window, const QString &path);
+
+    virtual bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    MainWindow *m_window;
+    QFile m_file;
+    QElapsedTimer m_clock;
+};
+
+//! Replays input recorded by `InputRecorder` against the same files without a screen.
+//! Prints input to frame latency percentiles of navigation and zoom as CSV to stdout. Returns process exit code
+int replayInput(const QString &path);
+
+} // namespace pork
+
+#endif // INPUTTRACE_H
@@ -1,13 +1,108 @@
 #include "mainwindow.h"
+#include "config.h"
+#include "benchmark.h"
+#include "singleinstance.h"
+#include "previewstore.h"
+#include "trace.h"
+#include "watchdog.h"
+#include "inputtrace.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QSettings>
 
 int main(int argc, char *argv[])
 {
+    // cold start is measured from here
+    pork::uptime();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QCoreApplication::translate("main", "Image and video viewer"));
+    parser.addHelpOption();
+    parser.addOption({"benchmark", QCoreApplication::translate("main", "Print resampler comparison as CSV and quit. Pipeline benchmarks are the tests/benchmarks target.")});
+    parser.addOption({"prewarm", QCoreApplication::translate("main", "Store previews and thumbnails of <dir> pictures and quit."), "dir"});
+    parser.addOption({"trace", QCoreApplication::translate("main", "Record Chrome trace of the session to <file> at exit."), "file"});
+    parser.addOption({"record", QCoreApplication::translate("main", "Record input of the session to <file> for --replay."), "file"});
+    parser.addOption({"replay", QCoreApplication::translate("main", "Replay input recorded to <file>, print input to frame latency as CSV and quit."), "file"});
+    parser.addPositionalArgument("files", QCoreApplication::translate("main", "Files to open."), "[files...]");
+
+    // platform is chosen before the application exists, so arguments are looked at ahead of it.
+    // errors and help are reported by `process` below
+    QStringList arguments;
+    for(int i = 0; i < argc; ++i) {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+    parser.parse(arguments);
+
+    // benchmarks, cache seeding and input replay need no screen and no window.
+    // replay timings don't depend on a window manager then either
+    const bool headless { parser.isSet("benchmark") || parser.isSet("prewarm") || parser.isSet("replay") };
+    if(headless) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
     QApplication a(argc, argv);
     a.setApplicationName("Pork");
+    parser.process(a);
+
+    if(parser.isSet("benchmark")) {
+        return pork::runBenchmark();
+    }
+    if(parser.isSet("prewarm")) {
+        return pork::prewarm(parser.value("prewarm"));
+    }
+    if(parser.isSet("replay")) {
+        return pork::replayInput(parser.value("replay"));
+    }
+
+    QStringList files;
+    for(const QString &file : parser.positionalArguments()) {
+        // running instance may have another working directory
+        files << QFileInfo(file).absoluteFilePath();
+    }
+
+    // running instance has its caches and libvlc warm already
+    pork::SingleInstance instance;
+    if(instance.forward(files)) {
+        return 0;
+    }
+
+    // lost the race to the instance launched at the same moment
+    if(!instance.listen() && instance.forward(files)) {
+        return 0;
+    }
+
+    // recording starts before the window, so the first open is in the trace
+    const QString traceFile { parser.value("trace") };
+    if(!traceFile.isEmpty()) {
+        pork::trace::start();
+        QObject::connect(&a, &QApplication::aboutToQuit, [traceFile]() {
+            pork::trace::stop();
+            pork::trace::dump(traceFile);
+        });
+    }
+
+    // freezes of the gui thread are logged for field reports
+    const QSettings settings("PitM", "Pork");
+    pork::Watchdog watchdog(settings.value(pork::tune::reg::stallThreshold, pork::tune::watchdog::threshold).toInt());
+    watchdog.start();
 
     pork::MainWindow w;
+    QObject::connect(&instance, &pork::SingleInstance::filesReceived, &w, [&w](const QStringList &files) {
+        if(!files.isEmpty()) {
+            w.openFile(files.first());
+        }
+        w.raise();
+        w.activateWindow();
+    });
     w.show();
 
+    if(parser.isSet("record")) {
+        new pork::InputRecorder(&w, parser.value("record"));
+    }
+
+    if(!files.isEmpty()) {
+        w.openFile(files.first());
+    }
+
     return a.exec();
 }
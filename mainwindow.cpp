@@ -3,6 +3,11 @@
 
 #include "config.h"
 #include "utils.h"
+#include "classifier.h"
+#include "tiledimage.h"
+#include "gridview.h"
+#include "trace.h"
+#include "watchdog.h"
 
 #include <QMessageBox>
 #include <QDropEvent>
@@ -11,6 +16,8 @@
 #include <QScrollBar>
 #include <QDebug>
 #include <QScreen>
+#include <QStandardPaths>
+#include <QDateTime>
 #include <functional>
 
 namespace pork {
@@ -22,10 +29,61 @@ MainWindow::MainWindow(QWidget *parent)
     , m_videoPlayer(this)
 {
     ui->setupUi(this);
-    m_videoPlayer.setWidgets(ui->videoView, ui->progressSlider, ui->volumeSlider, ui->codecErrorLabel);
+    m_videoPlayer.setWidgets(ui->videoView, ui->videoStandbyView, ui->progressSlider, ui->volumeSlider, ui->codecErrorLabel);
     connect(&m_videoPlayer, &VideoPlayer::loaded, this, [this](){
         calcVideoFactor(m_videoPlayer.videoSize());
     });
+    connect(&m_gifPlayer, &AnimationPlayer::frameChanged, ui->label, &QLabel::setPixmap);
+    connect(&m_gifPlayer, &AnimationPlayer::frameChanged, this, &MainWindow::frameShown);
+    connect(&m_videoPlayer, &VideoPlayer::loaded, this, &MainWindow::frameShown);
+    connect(ui->imageView, &ImageView::painted, this, &MainWindow::frameShown);
+
+    // neighbours show up while the directory is still being scanned
+    connect(&m_dirIndex, &DirIndex::changed, this, [this]() {
+        if(m_appMode == AppMode::Fullscreen) {
+            prefetchNeighbours();
+        }
+    });
+
+    ui->gridView->setIndex(&m_dirIndex);
+    connect(ui->gridView, &GridView::closeRequested, this, [this]() {
+        hideGrid();
+        loadFile();
+    });
+    connect(ui->gridView, &GridView::activated, this, [this](const QString &fileName) {
+        m_currentFile = QFileInfo { m_dirIndex.filePath(fileName) };
+        hideGrid();
+        loadFile();
+        prefetchNeighbours();
+    });
+    connect(&m_imageWatcher, &QFutureWatcher<DecodedImage>::finished, this, [this](){
+        if(m_imageWatcher.isCanceled() || !m_imageWatcher.future().resultCount()) {
+            return;
+        }
+
+        // user may have moved to another file already
+        const DecodedImage decoded { m_imageWatcher.result() };
+        if(decoded.file == m_pendingImage) {
+            m_pendingImage.clear();
+            showImage(decoded);
+        }
+    });
+    connect(&m_fullImageWatcher, &QFutureWatcher<DecodedImage>::finished, this, [this](){
+        if(m_fullImageWatcher.isCanceled() || !m_fullImageWatcher.future().resultCount()) {
+            return;
+        }
+
+        const DecodedImage decoded { m_fullImageWatcher.result() };
+        if(decoded.file == m_fullImage && m_pendingImage.isEmpty() && m_mediaMode == MediaMode::Image && !decoded.image.isNull()) {
+            m_image = decoded.image;
+            ui->imageView->setImage(m_image);
+            applyImage();
+        }
+    });
+    const QSize fitSize { pork::screen().size() - QSize(tune::screen::reserve, tune::screen::reserve) };
+    m_imageCache.setFitSize(fitSize);
+    // `--prewarm` makes previews of this size
+    m_settings.setValue(tune::reg::previewSize, fitSize);
     ui->fileNameLabel->setContentsMargins(tune::info::fileName::pad, tune::info::fileName::pad, 0, 0);
     ui->progressSlider->setMinimum(0);
     ui->progressSlider->setMaximum(tune::slider::range-1);
@@ -33,9 +91,26 @@ MainWindow::MainWindow(QWidget *parent)
     block(ui->scrollArea);
     block(ui->videoPane);
 
+    // zoom steps are applied once per display frame
+    const qreal refreshRate { QGuiApplication::primaryScreen() ? QGuiApplication::primaryScreen()->refreshRate() : 60 };
+    m_zoomFrameTimer.setSingleShot(true);
+    m_zoomFrameTimer.setInterval(qRound(1000/refreshRate));
+    connect(&m_zoomFrameTimer, &QTimer::timeout, this, &MainWindow::applyZoom);
+
+    m_zoomSettleTimer.setSingleShot(true);
+    m_zoomSettleTimer.setInterval(tune::zoom::settleTime);
+    connect(&m_zoomSettleTimer, &QTimer::timeout, this, [this]() {
+        ui->imageView->setSmooth(true);
+    });
+
     m_fileNameTimer.setSingleShot(true);
     connect(&m_fileNameTimer, &QTimer::timeout, ui->fileNameLabel, &QLabel::hide);
 
+    ui->perfLabel->setContentsMargins(tune::info::hud::pad, tune::info::hud::pad, tune::info::hud::pad, tune::info::hud::pad);
+    ui->perfLabel->hide();
+    m_hudTimer.setInterval(tune::info::hud::refreshTime);
+    connect(&m_hudTimer, &QTimer::timeout, this, &MainWindow::updateHud);
+
     setMediaMode(MediaMode::Image);
     setAppMode(AppMode::DragDialog);
 
@@ -63,12 +138,8 @@ void MainWindow::dragEnterEvent(QDragEnterEvent *event)
 
     QString url { data->urls().first().toString() };
 
-    bool pic { fileBelongsTo(url, cap::supportedImages()) };
-    bool gif { fileBelongsTo(url, cap::supportedGif()) };
-    bool video { fileBelongsTo(url, cap::supportedVideo()) };
-
-    const bool any {pic || gif || video};
-    if(!any) {
+    MediaMode mode;
+    if(!classify(url, mode)) {
         event->ignore();
         return;
     }
@@ -115,29 +186,49 @@ void MainWindow::resizeEvent(QResizeEvent *event)
     ui->progressSlider->setGeometry(progress);
 
     ui->fileNameLabel->resize(window.width(), tune::info::fileName::fontSize*2 + tune::info::fileName::pad);
+    ui->perfLabel->move(tune::info::fileName::pad, ui->fileNameLabel->geometry().bottom() + tune::info::fileName::pad);
 }
 
 void MainWindow::setAppMode(AppMode type)
 {
+    PORK_OPERATION("MainWindow::setAppMode");
+
     m_appMode = type;
     if(type == AppMode::Fullscreen) {
         showFullScreen();
         ui->fileNameLabel->show();
     } else {
+        m_pendingImage.clear();
+        m_image = QImage();
         setMediaMode(MediaMode::Image);
-        ui->label->clear();
+        ui->imageView->hide();
+        ui->label->show();
         showNormal();
         setLabelText(ui->label, tr("Drag image/video here..."), tune::info::dragLabelColor);
         ui->fileNameLabel->hide();
+        ui->perfLabel->hide();
+        m_hudTimer.stop();
     }
 }
 
 bool MainWindow::openFile(const QString &filename)
 {
+    PORK_TRACE("MainWindow::openFile");
+    PORK_OPERATION("MainWindow::openFile");
+
+    if(ui->gridView->isVisible()) {
+        hideGrid();
+    }
+
+    m_inputTimer.start();
+    m_hud.reset();
+
     m_currentFile = QFileInfo {filename};
+    m_dirIndex.setPath(m_currentFile.absolutePath(), m_currentFile.fileName());
     bool ok { loadFile() };
     if(ok) {
         setAppMode(AppMode::Fullscreen);
+        prefetchNeighbours();
     }
 
     return ok;
@@ -145,21 +236,21 @@ bool MainWindow::openFile(const QString &filename)
 
 bool MainWindow::loadFile()
 {
-    QString filePath { m_currentFile.absoluteFilePath() };
+    PORK_TRACE("MainWindow::loadFile");
+    PORK_OPERATION("MainWindow::loadFile");
 
-    // check gifs first since *.webp is supported both by `QMovie`
-    // and simple `QImageReader`.
-    // but we'll prefer `QMovie` since content may be animated.
-    if(fileBelongsTo(filePath, cap::supportedGif())) {
-        return loadGif();
-    }
+    m_pendingImage.clear();
 
-    if(fileBelongsTo(filePath, cap::supportedImages())) {
-        return loadImage();
+    MediaMode mode;
+    if(!classify(m_currentFile.fileName(), mode)) {
+        return false;
     }
 
-    if(fileBelongsTo(filePath, cap::supportedVideo())) {
-        return loadVideo();
+    // pictures and animations are told apart by the decoder sniffing their content on a worker
+    switch(mode) {
+        case MediaMode::Image:
+        case MediaMode::Gif:   return loadImage();
+        case MediaMode::Video: return loadVideo();
     }
 
     return false;
@@ -168,41 +259,90 @@ bool MainWindow::loadFile()
 bool MainWindow::loadImage()
 {
     QString filePath { m_currentFile.absoluteFilePath() };
+    setLabelText(ui->fileNameLabel, m_currentFile.fileName(), tune::info::fileName::darkColor, tune::info::fileName::fontSize);
+    ui->fileNameLabel->show();
+    m_fileNameTimer.start(tune::info::fileName::showTime);
+
+    QFuture<DecodedImage> future { m_imageCache.request(filePath) };
+
+    if(future.isFinished()) {
+        return showImage(future.result());
+    }
+
+    // previous picture stays on a screen until the new one is decoded
+    m_pendingImage = filePath;
+    m_imageWatcher.setFuture(future);
 
-    QImageReader reader(filePath);
-    reader.setAutoTransform(true);
-    m_image = reader.read();
-    if (m_image.isNull()) {
+    return true;
+}
+
+bool MainWindow::showImage(const DecodedImage &decoded)
+{
+    PORK_TRACE("MainWindow::showImage");
+    PORK_OPERATION("MainWindow::showImage");
+
+    if(decoded.animated) {
+        return showAnimation(decoded);
+    }
+
+    if (decoded.image.isNull()) {
         QMessageBox::information(this, QGuiApplication::applicationDisplayName(),
                                  tr("Cannot load %1: %2")
-                                 .arg(QDir::toNativeSeparators(filePath), reader.errorString()));
+                                 .arg(QDir::toNativeSeparators(decoded.file), decoded.error));
+
+        // nothing to show at all
+        if(m_image.isNull()) {
+            setAppMode(AppMode::DragDialog);
+        }
         return false;
     }
 
+    m_image = decoded.image;
+    m_imageFullSize = decoded.fullSize;
+    m_imageTiled = decoded.tiled;
+    m_fullImage.clear();
+
+    m_hud.setOrigin(decoded.origin);
+    m_hud.setStage(PerfHud::Decode, decoded.decodeTime);
+    m_hud.setStage(PerfHud::Convert, decoded.convertTime);
+
+    QElapsedTimer timer;
+    timer.start();
+
     setMediaMode(MediaMode::Image);
+    if(decoded.tiled) {
+        ui->imageView->setImage(m_image, QSharedPointer<TiledImage>::create(decoded.file, decoded.fullSize));
+    } else {
+        ui->imageView->setImage(m_image);
+    }
 
     calcImageFactor();
     applyImage();
 
-    setLabelText(ui->fileNameLabel, m_currentFile.fileName(), tune::info::fileName::darkColor, tune::info::fileName::fontSize);
-    ui->fileNameLabel->show();
-    m_fileNameTimer.start(tune::info::fileName::showTime);
+    m_hud.setStage(PerfHud::View, timer.nsecsElapsed()/1000);
+    if(m_inputTimer.isValid()) {
+        m_hud.setStage(PerfHud::Input, m_inputTimer.nsecsElapsed()/1000);
+        m_inputTimer.invalidate();
+    }
+
+    if(!m_firstImageShown) {
+        m_firstImageShown = true;
+        trace::instant("first picture shown");
+
+        if(tune::video::warmUp) {
+            QTimer::singleShot(tune::video::warmUpDelay, &m_videoPlayer, &VideoPlayer::warmUp);
+        }
+    }
 
     return true;
 }
 
-bool MainWindow::loadGif()
+bool MainWindow::showAnimation(const DecodedImage &decoded)
 {
-    QString filePath { m_currentFile.absoluteFilePath() };
-    setLabelText(ui->fileNameLabel, m_currentFile.fileName(), tune::info::fileName::darkColor, tune::info::fileName::fontSize);
-    ui->fileNameLabel->show();
-    m_fileNameTimer.start(tune::info::fileName::showTime);
-
     setMediaMode(MediaMode::Gif);
-    m_gifPlayer.setFileName(filePath);
-    m_gifOriginalSize = QImageReader(filePath).size();
+    m_gifPlayer.setFileName(decoded.file);
+    m_gifOriginalSize = decoded.fullSize;
     m_gifPlayer.setScaledSize(m_gifOriginalSize);
-    ui->label->setMovie(&m_gifPlayer);
     m_gifPlayer.start();
 
     return true;
@@ -229,32 +369,37 @@ void MainWindow::setMediaMode(MediaMode type)
 {
     m_mediaMode = type;
     m_scaleFactor = tune::zoom::origin;
+    m_zoomDelta = 0.0;
+    m_zoomFrameTimer.stop();
+    m_zoomSettleTimer.stop();
+    ui->imageView->setSmooth(true);
     ui->progressSlider->setValue(0);
     ui->volumeSlider->setValue(0);
     ui->codecErrorLabel->hide();
     ui->label->clear();
+    ui->imageView->clear();
 
     if(m_mediaMode == MediaMode::Video) {
         ui->label->hide();
+        ui->imageView->hide();
         ui->videoPane->show();
         ui->scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
         ui->scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-        m_zoomTimer.invalidate();
     } else {
         m_videoPlayer.stop();
         m_gifPlayer.stop();
         ui->videoPane->hide();
-        ui->label->show();
+        ui->label->setVisible(m_mediaMode == MediaMode::Gif);
+        ui->imageView->setVisible(m_mediaMode == MediaMode::Image);
         ui->scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
         ui->scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-        m_zoomTimer.start();
     }
 }
 
 void MainWindow::calcImageFactor()
 {
-    int w { m_image.width() };
-    int h { m_image.height() };
+    int w { m_imageFullSize.width() };
+    int h { m_imageFullSize.height() };
 
     qreal sW = screen().width() - tune::screen::reserve;
     qreal sH = screen().height() - tune::screen::reserve;
@@ -297,13 +442,17 @@ void MainWindow::calcVideoFactor(const QSizeF &nativeSize)
 
     QRectF geom(pos, s);
 
-    ui->videoView->setGeometry(geom.toRect());
-    ui->videoView->setMaximumSize(geom.size().toSize());
-    ui->videoView->setMinimumSize(geom.size().toSize());
+    VlcWidgetVideo *view { m_videoPlayer.view() };
+    view->setGeometry(geom.toRect());
+    view->setMaximumSize(geom.size().toSize());
+    view->setMinimumSize(geom.size().toSize());
 }
 
 void MainWindow::resetScale()
 {
+    m_zoomDelta = 0.0;
+    m_zoomFrameTimer.stop();
+
     if(m_mediaMode == MediaMode::Image) {
         calcImageFactor();
         applyImage();
@@ -315,12 +464,38 @@ void MainWindow::resetScale()
 
 void MainWindow::applyImage()
 {
-    if(almostEqual(m_scaleFactor, tune::zoom::origin)) {
-        ui->label->setPixmap(QPixmap::fromImage(m_image));
-    } else {
-        ui->label->setPixmap(QPixmap::fromImage(m_image)
-                             .scaled(m_image.size()*m_scaleFactor, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    PORK_OPERATION("MainWindow::applyImage");
+
+    if(m_image.isNull()) {
+        return;
+    }
+
+    const QSize size { m_imageFullSize*m_scaleFactor };
+
+    // `m_scaleFactor` is relative to full resolution while decoded picture may be smaller
+    ui->imageView->setScale(m_scaleFactor*m_imageFullSize.width()/m_image.width());
+
+    // zoomed past the fitted picture. full resolution is needed from now on
+    // huge pictures are detailed by `ImageView` itself
+    if(size.width() > m_image.width() && m_image.size() != m_imageFullSize && !m_imageTiled) {
+        requestFullImage();
+    }
+}
+
+void MainWindow::requestFullImage()
+{
+    const QString filePath { m_currentFile.absoluteFilePath() };
+    if(m_fullImage == filePath) {
+        return;
+    }
+
+    // huge pictures are detailed by tiles only, whatever the reason they are not
+    if(static_cast<qint64>(m_imageFullSize.width())*m_imageFullSize.height() > tune::tiled::threshold) {
+        return;
     }
+
+    m_fullImage = filePath;
+    m_fullImageWatcher.setFuture(m_imageCache.request(filePath, true));
 }
 
 void MainWindow::applyGif()
@@ -334,6 +509,12 @@ void MainWindow::videoRewind(Direction dir)
 }
 
 bool MainWindow::zoom(Direction dir, InputType type)
+{
+    // buttons zoom around the screen center
+    return zoomAround(dir, type, ui->scrollArea->viewport()->rect().center());
+}
+
+bool MainWindow::zoomAround(Direction dir, InputType type, const QPoint &anchor)
 {
     if(m_mediaMode == MediaMode::Video) {
         return false;
@@ -341,7 +522,7 @@ bool MainWindow::zoom(Direction dir, InputType type)
 
     qreal factor { tune::zoom::factors[dir][type] };
 
-    qreal result { m_scaleFactor + factor };
+    qreal result { m_scaleFactor + m_zoomDelta + factor };
     if(result <= tune::zoom::min) {
         return false;
     }
@@ -350,22 +531,57 @@ bool MainWindow::zoom(Direction dir, InputType type)
         return false;
     }
 
-    if(m_zoomTimer.elapsed() > tune::zoom::delay) {
-        m_scaleFactor = result;
+    m_zoomAnchor = anchor;
 
-        if(m_mediaMode == MediaMode::Image) {
-            applyImage();
-            centerScrollArea(ui->scrollArea, ui->label);
-        } else {
-            applyGif();
-        }
-
-        m_zoomTimer.restart();
+    // steps are accumulated and applied at once on the next frame
+    m_zoomDelta += factor;
+    if(!m_zoomFrameTimer.isActive()) {
+        m_zoomFrameTimer.start();
     }
 
     return true;
 }
 
+void MainWindow::applyZoom()
+{
+    PORK_TRACE("MainWindow::applyZoom");
+    PORK_OPERATION("MainWindow::applyZoom");
+
+    m_scaleFactor += m_zoomDelta;
+    m_zoomDelta = 0.0;
+
+    if(m_mediaMode == MediaMode::Gif) {
+        applyGif();
+        return;
+    }
+
+    if(m_mediaMode != MediaMode::Image || m_image.isNull()) {
+        return;
+    }
+
+    QWidget *viewport { ui->scrollArea->viewport() };
+    ImageView *view { ui->imageView };
+
+    // picture point under the anchor before zoom
+    const QPointF anchor { view->mapFrom(viewport, m_zoomAnchor) - view->offset() };
+    const QPointF imagePoint { anchor/view->scale() };
+
+    // intermediate frames are painted fast, smooth pass follows once gesture settles
+    view->setSmooth(false);
+    applyImage();
+    m_zoomSettleTimer.start();
+
+    // let scroll area adopt the new picture size before scrolling
+    ui->scrollAreaWidgetContents->layout()->activate();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::LayoutRequest);
+
+    const QPoint moved { view->mapTo(viewport, (imagePoint*view->scale()).toPoint() + view->offset()) - m_zoomAnchor };
+    auto hBar { ui->scrollArea->horizontalScrollBar() };
+    auto vBar { ui->scrollArea->verticalScrollBar() };
+    hBar->setValue(hBar->value() + moved.x());
+    vBar->setValue(vBar->value() + moved.y());
+}
+
 bool MainWindow::volumeStep(Direction dir, InputType type)
 {
     int value {ui->volumeSlider->value()};
@@ -384,27 +600,141 @@ bool MainWindow::volumeStep(Direction dir, InputType type)
 
 void MainWindow::gotoNextFile(Direction dir)
 {
-    QFileInfoList files { getDirFiles(m_currentFile.dir().path()) };
+    PORK_TRACE("MainWindow::gotoNextFile");
+    PORK_OPERATION("MainWindow::gotoNextFile");
 
-    if(files.empty()) {
+    const QString next { m_dirIndex.neighbour(m_currentFile.fileName(), dir) };
+    if(next.isEmpty()) {
         return;
     }
 
-    int i { files.indexOf(m_currentFile) };
-    if(dir == Direction::Backward) {
-        i -= 1;
-        if(i < 0) {
-            i = files.size()-1;
+    m_inputTimer.start();
+    m_hud.reset();
+
+    m_direction = dir;
+    m_currentFile = QFileInfo { m_dirIndex.filePath(next) };
+    loadFile();
+    prefetchNeighbours();
+}
+
+void MainWindow::showGrid()
+{
+    PORK_OPERATION("MainWindow::showGrid");
+
+    if(m_dirIndex.isEmpty()) {
+        return;
+    }
+
+    // nothing keeps playing behind the grid
+    m_videoPlayer.stop();
+    m_gifPlayer.stop();
+
+    ui->scrollArea->hide();
+    ui->fileNameLabel->hide();
+    ui->gridView->setCurrent(m_currentFile.fileName());
+    ui->gridView->show();
+    ui->gridView->setFocus();
+}
+
+void MainWindow::hideGrid()
+{
+    ui->gridView->hide();
+    ui->scrollArea->show();
+    setFocus();
+}
+
+void MainWindow::prefetchNeighbours()
+{
+    PORK_OPERATION("MainWindow::prefetchNeighbours");
+
+    QStringList neighbours;
+    const QString current { m_currentFile.fileName() };
+    const Direction back { m_direction == Direction::Forward ? Direction::Backward : Direction::Forward };
+
+    auto addNeighbour = [&](Direction dir, int distance) {
+        const QString file { m_dirIndex.neighbour(current, dir, distance) };
+        if(file == current) {
+            return;
         }
-    } else {
-        i += 1;
-        if(i >= files.size()) {
-            i = 0;
+
+        // gifs are decoded by `AnimationPlayer` at the current scale, there is nothing to decode in advance
+        MediaMode mode;
+        if(!classify(file, mode)) {
+            return;
         }
+
+        if(mode == MediaMode::Image) {
+            neighbours << m_dirIndex.filePath(file);
+        } else if(mode == MediaMode::Video && dir == m_direction && distance == 1) {
+            // only one standby player, so only the very next video is opened in advance
+            m_videoPlayer.preroll(m_dirIndex.filePath(file));
+        }
+    };
+
+    for(int i = 1; i <= tune::prefetch::ahead; ++i) {
+        addNeighbour(m_direction, i);
+    }
+    for(int i = 1; i <= tune::prefetch::behind; ++i) {
+        addNeighbour(back, i);
     }
 
-    m_currentFile = files[i];
-    loadFile();
+    neighbours.removeDuplicates();
+    m_imageCache.prefetch(neighbours);
+}
+
+void MainWindow::toggleHud()
+{
+    if(m_hudTimer.isActive()) {
+        m_hudTimer.stop();
+        ui->perfLabel->hide();
+        return;
+    }
+
+    updateHud();
+    ui->perfLabel->show();
+    m_hudTimer.start();
+}
+
+void MainWindow::updateHud()
+{
+    // paint stages are of the last paint, it may happen after the picture is shown
+    const ImageView::PaintStats &paint { ui->imageView->paintStats() };
+    m_hud.setStage(PerfHud::Listing, m_dirIndex.scanTime()*1000);
+    m_hud.setStage(PerfHud::Resample, paint.resample);
+    m_hud.setStage(PerfHud::Upload, paint.upload);
+    m_hud.setStage(PerfHud::Paint, paint.total);
+    m_hud.setCache(PerfHud::Images, m_imageCache.hits(), m_imageCache.misses());
+    m_hud.setCache(PerfHud::Tiles, paint.cachedTiles, paint.tiles - paint.cachedTiles);
+    m_hud.setMemory(m_imageCache.memoryUsed() + ui->imageView->memoryUsed());
+    m_hud.setScale(m_scaleFactor);
+
+    setLabelText(ui->perfLabel, m_hud.text(), tune::info::hud::color, tune::info::hud::fontSize);
+    ui->perfLabel->adjustSize();
+}
+
+void MainWindow::toggleTrace()
+{
+    if(!trace::isEnabled()) {
+        trace::start();
+        setLabelText(ui->fileNameLabel, tr("Tracing..."), tune::info::fileName::lightColor, tune::info::fileName::fontSize, true);
+        ui->fileNameLabel->show();
+        m_fileNameTimer.start(tune::info::fileName::showTime);
+        return;
+    }
+
+    trace::stop();
+
+    const QString dir { QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) };
+    QDir().mkpath(dir);
+    const QString path { QDir(dir).filePath(QStringLiteral("trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))) };
+    if(trace::dump(path)) {
+        setLabelText(ui->fileNameLabel, tr("Trace saved to %1").arg(QDir::toNativeSeparators(path)), tune::info::fileName::lightColor, tune::info::fileName::fontSize, true);
+        ui->fileNameLabel->show();
+        m_fileNameTimer.start(tune::info::fileName::showTime);
+    } else {
+        QMessageBox::information(this, QGuiApplication::applicationDisplayName(),
+                                 tr("Cannot save trace to %1").arg(QDir::toNativeSeparators(path)));
+    }
 }
 
 bool MainWindow::dragImage(QPoint p)
@@ -429,7 +759,7 @@ bool MainWindow::dragImage(QPoint p)
 
 void MainWindow::onClick()
 {
-    QWidget *w { ui->videoView->childAt(m_clickPoint) };
+    QWidget *w { m_videoPlayer.view()->childAt(m_clickPoint) };
     if(w == ui->volumeSlider || w == ui->progressSlider) {
         return;
     }
@@ -457,7 +787,8 @@ void MainWindow::onClick()
 
 bool MainWindow::event(QEvent *event)
 {
-    if(m_appMode == AppMode::DragDialog) {
+    // grid handles its input itself
+    if(m_appMode == AppMode::DragDialog || ui->gridView->isVisible()) {
         return QMainWindow::event(event);
     }
 
@@ -482,6 +813,9 @@ bool MainWindow::event(QEvent *event)
                 case Qt::Key_Down:   zoomOrVolumeStep(Direction::Backward, InputType::Button); return true;
                 case Qt::Key_Space:  videoMode ? m_videoPlayer.toggle() : resetScale(); return true;
                 case Qt::Key_Return: resetScale(); return true;
+                case Qt::Key_G:      showGrid(); return true;
+                case Qt::Key_F3:     toggleHud(); return true;
+                case Qt::Key_F4:     toggleTrace(); return true;
                 default: break;
             }
         } break;
@@ -489,7 +823,13 @@ bool MainWindow::event(QEvent *event)
         case QEvent::Wheel: {
             QWheelEvent *wheelEvent { static_cast<QWheelEvent *>(event) };
             Direction dir { wheelEvent->delta() > 0 ? Direction::Forward : Direction::Backward };
-            zoomOrVolumeStep(dir, InputType::Wheel);
+            if(videoMode) {
+                volumeStep(dir, InputType::Wheel);
+            } else {
+                // the point the event was made at, not where the cursor is now. replayed events have no cursor at all
+                const QPoint anchor { ui->scrollArea->viewport()->mapFrom(this, wheelEvent->position().toPoint()) };
+                zoomAround(dir, InputType::Wheel, anchor);
+            }
             return true;
         }
 
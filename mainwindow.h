@@ -2,10 +2,14 @@
 #define MAINWINDOW_H
 
 #include "videoplayer.h"
+#include "imagecache.h"
+#include "dirindex.h"
+#include "animationplayer.h"
+#include "perfhud.h"
 
 #include <QMainWindow>
+#include <QTimer>
 #include <QElapsedTimer>
-#include <QMovie>
 #include <QFileInfo>
 #include <QSettings>
 
@@ -29,13 +33,6 @@ enum InputType
     Wheel
 };
 
-enum MediaMode
-{
-    Image = 0,
-    Gif,
-    Video
-};
-
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -51,22 +48,41 @@ public:
     bool openFile(const QString &fileName);
     bool loadFile();
     bool loadImage();
-    bool loadGif();
+    bool showImage(const DecodedImage &decoded);
+    bool showAnimation(const DecodedImage &decoded);
     bool loadVideo();
     void calcImageFactor();
     void calcVideoFactor(const QSizeF &nativeSize);
     void resetScale();
     void applyImage();
+    void requestFullImage();
     void applyGif();
     void gotoNextFile(Direction dir);
+    void showGrid();
+    void hideGrid();
+    void prefetchNeighbours();
+    void toggleHud();
+    void updateHud();
+    void toggleTrace();
     bool dragImage(QPoint p);
 
     void videoRewind(Direction dir);
     bool zoom(Direction dir, InputType type);
+    bool zoomAround(Direction dir, InputType type, const QPoint &anchor); //! `anchor` is in viewport coordinates
+    void applyZoom();
     bool volumeStep(Direction dir, InputType type);
 
     void onClick();
 
+    const QFileInfo &currentFile() const { return m_currentFile; }
+    qreal scale() const { return m_scaleFactor; }
+    //! no picture is being decoded and no zoom step waits for a frame
+    bool isSettled() const { return m_pendingImage.isEmpty() && !m_zoomFrameTimer.isActive(); }
+
+signals:
+    //! picture painted, animation frame or video shown
+    void frameShown();
+
 protected:
     virtual void resizeEvent(QResizeEvent *event) override;
     virtual bool event(QEvent *event) override;
@@ -82,15 +98,31 @@ private:
     AppMode m_appMode { AppMode::DragDialog };
 
     QFileInfo m_currentFile;
+    DirIndex m_dirIndex;
+    Direction m_direction { Direction::Forward };
 
     QImage m_image;
-    QMovie m_gifPlayer;
+    ImageCache m_imageCache;
+    QFutureWatcher<DecodedImage> m_imageWatcher;
+    QString m_pendingImage;
+    QFutureWatcher<DecodedImage> m_fullImageWatcher;
+    QString m_fullImage;
+    QSize m_imageFullSize;
+    bool m_imageTiled { false };
+    bool m_firstImageShown { false };
+    AnimationPlayer m_gifPlayer;
     VideoPlayer m_videoPlayer;
 
     QSize m_gifOriginalSize;
     qreal m_scaleFactor { 1.0 };
-    QElapsedTimer m_zoomTimer;
+    qreal m_zoomDelta { 0.0 };  //! zoom accumulated since the last frame
+    QPoint m_zoomAnchor;        //! viewport point which stays in place while zooming
+    QTimer m_zoomFrameTimer;
+    QTimer m_zoomSettleTimer;
     QTimer m_fileNameTimer;
+    PerfHud m_hud;
+    QTimer m_hudTimer;
+    QElapsedTimer m_inputTimer; //! runs from open or navigation request till the picture is shown
     QPoint m_clickPoint;
     bool m_mouseDraging { false };
 };
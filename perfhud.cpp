@@ -0,0 +1,49 @@
+#include "perfhud.h"
+
+#include <QStringList>
+#include <algorithm>
+#include <iterator>
+
+namespace pork {
+
+void PerfHud::reset()
+{
+    std::fill(std::begin(m_stages), std::end(m_stages), -1);
+    m_origin = DecodedImage::Decoder;
+}
+
+void PerfHud::setCache(Cache cache, int hits, int misses)
+{
+    m_hits[cache] = hits;
+    m_misses[cache] = misses;
+}
+
+QString PerfHud::text() const
+{
+    static const char *stageNames[StageCount] { "listing", "decode", "convert", "view", "resample", "upload", "paint", "input to picture" };
+    static const char *originNames[] { "decoder", "preview store", "memory cache" };
+    static const char *cacheNames[CacheCount] { "images", "tiles" };
+
+    QStringList lines;
+    for(int i = 0; i < StageCount; ++i) {
+        // decoding stages are of no interest when the picture was not decoded
+        const bool decoding { i == Decode || i == Convert };
+        if(m_stages[i] < 0 || (decoding && m_origin != DecodedImage::Decoder)) {
+            lines << QStringLiteral("%1: -").arg(stageNames[i]);
+        } else {
+            lines << QStringLiteral("%1: %2 ms").arg(stageNames[i]).arg(m_stages[i]/1000.0, 0, 'f', 2);
+        }
+    }
+
+    lines << QStringLiteral("source: %1").arg(originNames[m_origin]);
+    for(int i = 0; i < CacheCount; ++i) {
+        const int total { m_hits[i] + m_misses[i] };
+        lines << QStringLiteral("%1 cache hits: %2% of %3").arg(cacheNames[i]).arg(total ? 100*m_hits[i]/total : 0).arg(total);
+    }
+    lines << QStringLiteral("image memory: %1 MB").arg(m_memory/1024.0, 0, 'f', 1);
+    lines << QStringLiteral("scale: %1%").arg(m_scale*100, 0, 'f', 1);
+
+    return lines.join("<br>");
+}
+
+} // namespace pork
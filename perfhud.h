@@ -0,0 +1,57 @@
+#ifndef PERFHUD_H
+#define PERFHUD_H
+
+#include "imagecache.h"
+
+#include <QString>
+
+namespace pork {
+
+//! Text of the performance overlay: timings of the current file stages, cache hit rates, memory use and scale.
+//! Values are pushed by the code around the stages, the overlay only formats them.
+class PerfHud
+{
+public:
+    enum Stage
+    {
+        Listing = 0, //! directory scan
+        Decode,
+        Convert,     //! to display format
+        View,        //! handing the picture to `ImageView`
+        Resample,    //! of the tiles of the last paint
+        Upload,      //! `QPixmap` conversion of the tiles of the last paint
+        Paint,       //! the whole last paint
+        Input,       //! from the open or navigation request to the picture on a screen
+        StageCount
+    };
+
+    enum Cache
+    {
+        Images = 0,
+        Tiles,
+        CacheCount
+    };
+
+    //! new file. its stages are not measured yet
+    void reset();
+
+    void setStage(Stage stage, qint64 us) { m_stages[stage] = us; }
+    void setOrigin(DecodedImage::Origin origin) { m_origin = origin; }
+    void setCache(Cache cache, int hits, int misses);
+    void setMemory(int kb) { m_memory = kb; }
+    void setScale(qreal scale) { m_scale = scale; }
+
+    QString text() const;
+
+private:
+    qint64 m_stages[StageCount] {-1, -1, -1, -1, -1, -1, -1, -1}; //! in us. negative when not measured
+    DecodedImage::Origin m_origin {DecodedImage::Decoder};
+    int m_hits[CacheCount] {};
+    int m_misses[CacheCount] {};
+    int m_memory {0};
+    qreal m_scale {1.0};
+};
+
+} // namespace pork
+
+#endif // PERFHUD_H
@@ -0,0 +1,384 @@
+#include "previewstore.h"
+#include "config.h"
+#include "utils.h"
+#include "classifier.h"
+#include "imagecache.h"
+#include "resampler.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+
+namespace pork {
+
+static constexpr quint32 indexMagic {0x504F524B}; // "PORK"
+static constexpr quint32 indexVersion {1};
+
+PreviewStore &PreviewStore::instance()
+{
+    static PreviewStore store;
+    return store;
+}
+
+PreviewStore::PreviewStore()
+    : m_dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/previews")
+{
+    m_pool.setMaxThreadCount(1);
+    QDir().mkpath(m_dir);
+    load();
+}
+
+PreviewStore::~PreviewStore()
+{
+    m_pool.waitForDone();
+
+    QMutexLocker lock(&m_mutex);
+    if(m_unsaved) {
+        save();
+    }
+}
+
+QByteArray PreviewStore::key(const QFileInfo &info, const QSize &box)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << info.absoluteFilePath() << info.size() << info.lastModified().toMSecsSinceEpoch() << box;
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+void PreviewStore::unmap(void *mapping)
+{
+    Mapping *m { static_cast<Mapping *>(mapping) };
+    {
+        QMutexLocker lock(&m->pack->mutex);
+        m->pack->file.unmap(m->data);
+    }
+    delete m;
+}
+
+PreviewStore::Pack::~Pack()
+{
+    if(!obsolete) {
+        return;
+    }
+
+    // the file is unmapped by now. leftovers are removed on the next start anyway
+    file.close();
+    if(!file.remove()) {
+        qDebug() << "cannot remove old preview pack:" << file.errorString();
+    }
+}
+
+QString PreviewStore::packPath(quint32 generation) const
+{
+    return QStringLiteral("%1/pack-%2.bin").arg(m_dir).arg(generation);
+}
+
+QString PreviewStore::indexPath() const
+{
+    return m_dir + "/index.bin";
+}
+
+QSharedPointer<PreviewStore::Pack> PreviewStore::openPack(quint32 generation, bool truncate) const
+{
+    QSharedPointer<Pack> pack { QSharedPointer<Pack>::create() };
+    pack->file.setFileName(packPath(generation));
+
+    QIODevice::OpenMode mode { QIODevice::ReadWrite };
+    if(truncate) {
+        mode |= QIODevice::Truncate;
+    }
+    if(!pack->file.open(mode)) {
+        qDebug() << "preview store is disabled:" << pack->file.errorString();
+        return {};
+    }
+
+    pack->generation = generation;
+    return pack;
+}
+
+QImage PreviewStore::find(const QFileInfo &info, const QSize &box, QSize *fullSize)
+{
+    const QByteArray k { key(info, box) };
+
+    QMutexLocker lock(&m_mutex);
+    auto it { m_entries.find(k) };
+    if(!m_pack || it == m_entries.end()) {
+        return QImage();
+    }
+
+    it->used = ++m_clock;
+    const Entry entry { *it };
+    const QSharedPointer<Pack> pack { m_pack };
+    lock.unlock();
+
+    uchar *data {nullptr};
+    {
+        QMutexLocker packLock(&pack->mutex);
+        data = pack->file.map(entry.offset, entry.size());
+    }
+    if(!data) {
+        return QImage();
+    }
+
+    if(fullSize) {
+        *fullSize = entry.fullSize;
+    }
+
+    // read-only pixels. the mapping is released with the last copy of the image
+    const uchar *bits { data };
+    return QImage(bits, entry.width, entry.height, entry.bytesPerLine, static_cast<QImage::Format>(entry.format),
+                  &PreviewStore::unmap, new Mapping { pack, data });
+}
+
+void PreviewStore::insert(const QFileInfo &info, const QSize &box, const QImage &image, const QSize &fullSize)
+{
+    if(image.isNull()) {
+        return;
+    }
+
+    // stored as painted, so mapped images need no conversion later
+    const QImage pixels { toDisplayFormat(image) };
+
+    const qint64 cap { static_cast<qint64>(tune::store::diskCap)*1024*1024 };
+    const qint64 bytes { pixels.sizeInBytes() };
+    if(bytes > cap/4) {
+        return;
+    }
+
+    const QByteArray k { key(info, box) };
+
+    // only the place in the pack is reserved under the store lock. lookups never wait for disk
+    QMutexLocker lock(&m_mutex);
+    if(!m_pack || m_compacting || m_entries.contains(k) || m_writing.contains(k)) {
+        return;
+    }
+
+    if(m_packSize + bytes > cap) {
+        // entries coming while the pack is compacted are not stored
+        m_compacting = true;
+        QtConcurrent::run(&m_pool, [this, bytes]() { compact(bytes); });
+        return;
+    }
+
+    const QSharedPointer<Pack> pack { m_pack };
+    const qint64 offset { m_packSize };
+    m_packSize += bytes;
+    m_writing.insert(k);
+    lock.unlock();
+
+    bool written {false};
+    {
+        QMutexLocker packLock(&pack->mutex);
+        QFile &file { pack->file };
+        written = file.seek(offset) && file.write(reinterpret_cast<const char *>(pixels.constBits()), bytes) == bytes && file.flush();
+        if(!written) {
+            qDebug() << "cannot write preview store:" << file.errorString();
+        }
+    }
+
+    // failed write leaves a hole which is dropped by the next compaction
+    lock.relock();
+    m_writing.remove(k);
+    if(!written || pack != m_pack) {
+        return;
+    }
+
+    m_entries.insert(k, Entry { offset, pixels.width(), pixels.height(), pixels.bytesPerLine(), static_cast<qint32>(pixels.format()), fullSize, ++m_clock });
+
+    // index is saved in batches. entries written after the last save are lost on crash, but nothing else is
+    if(++m_unsaved >= tune::store::saveEvery) {
+        save();
+    }
+}
+
+void PreviewStore::compact(qint64 incoming)
+{
+    const qint64 budget { static_cast<qint64>(tune::store::diskCap*tune::store::keepRatio)*1024*1024 - incoming };
+
+    QMutexLocker lock(&m_mutex);
+    const QSharedPointer<Pack> old { m_pack };
+    const QHash<QByteArray, Entry> entries { m_entries };
+    lock.unlock();
+
+    QVector<QPair<quint64, QByteArray>> order;
+    order.reserve(entries.size());
+    for(auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        order << qMakePair(it->used, it.key());
+    }
+    std::sort(order.begin(), order.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+
+    // the new pack is unknown to anybody till it's complete, so lookups keep mapping the old one meanwhile
+    const QSharedPointer<Pack> pack { openPack(old->generation + 1, true) };
+
+    // the most recently used entries are moved to the new pack while they fit the budget
+    QHash<QByteArray, Entry> kept;
+    qint64 size {0};
+    for(const auto &item : order) {
+        if(!pack) {
+            break;
+        }
+
+        Entry entry { entries.value(item.second) };
+        if(size + entry.size() > budget) {
+            continue;
+        }
+
+        QMutexLocker oldLock(&old->mutex);
+        uchar *data { old->file.map(entry.offset, entry.size()) };
+        if(!data) {
+            continue;
+        }
+        const bool ok { pack->file.write(reinterpret_cast<const char *>(data), entry.size()) == entry.size() };
+        old->file.unmap(data);
+        if(!ok) {
+            break;
+        }
+
+        entry.offset = size;
+        size += entry.size();
+        kept.insert(item.second, entry);
+    }
+    if(pack) {
+        pack->file.flush();
+    }
+
+    qDebug() << "preview store compacted:" << entries.size() << "->" << kept.size() << "entries";
+
+    lock.relock();
+
+    // lookups made during compaction are not forgotten
+    for(auto it = kept.begin(); it != kept.end(); ++it) {
+        it->used = m_entries.value(it.key(), it.value()).used;
+    }
+
+    m_pack = pack;
+    m_generation = pack ? pack->generation : m_generation;
+    m_entries = pack ? kept : QHash<QByteArray, Entry>();
+    m_packSize = size;
+    m_compacting = false;
+    save();
+    lock.unlock();
+
+    // images mapped from the old pack stay valid. the file is removed with the last of them
+    old->obsolete = true;
+}
+
+void PreviewStore::load()
+{
+    QFile index(indexPath());
+    if(index.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&index);
+        quint32 magic, version;
+        stream >> magic >> version;
+
+        if(magic == indexMagic && version == indexVersion) {
+            int count;
+            stream >> m_generation >> m_packSize >> m_clock >> count;
+            for(int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+                QByteArray k;
+                Entry entry;
+                stream >> k >> entry.offset >> entry.width >> entry.height >> entry.bytesPerLine >> entry.format >> entry.fullSize >> entry.used;
+                m_entries.insert(k, entry);
+            }
+        }
+
+        if(stream.status() != QDataStream::Ok) {
+            m_entries.clear();
+        }
+    }
+
+    // pack must hold everything the index refers to, otherwise nothing is trusted
+    const bool trusted { !m_entries.isEmpty() && QFileInfo(packPath(m_generation)).size() >= m_packSize };
+    if(!trusted) {
+        m_entries.clear();
+        m_packSize = 0;
+    }
+    m_pack = openPack(m_generation, !trusted);
+
+    // leftovers of compaction interrupted by crash
+    const QString current { QFileInfo(packPath(m_generation)).fileName() };
+    for(const QString &file : QDir(m_dir).entryList({"pack-*.bin"}, QDir::Files)) {
+        if(file != current && !QFile::remove(QDir(m_dir).filePath(file))) {
+            qDebug() << "cannot remove old preview pack:" << file;
+        }
+    }
+}
+
+void PreviewStore::save()
+{
+    QSaveFile index(indexPath());
+    if(!index.open(QIODevice::WriteOnly)) {
+        qDebug() << "cannot save preview store index:" << index.errorString();
+        return;
+    }
+
+    QDataStream stream(&index);
+    stream << indexMagic << indexVersion << m_generation << m_packSize << m_clock << m_entries.size();
+    for(auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        const Entry &entry { it.value() };
+        stream << it.key() << entry.offset << entry.width << entry.height << entry.bytesPerLine << entry.format << entry.fullSize << entry.used;
+    }
+
+    if(index.commit()) {
+        m_unsaved = 0;
+    }
+}
+
+int prewarm(const QString &path)
+{
+    // previews are stored for the size the viewer asked for the last time
+    const QSize screenSize { pork::screen().size() - QSize(tune::screen::reserve, tune::screen::reserve) };
+    const QSize previewSize { QSettings("PitM", "Pork").value(tune::reg::previewSize, screenSize).toSize() };
+    const QSize thumbSize { tune::grid::thumbSize, tune::grid::thumbSize };
+
+    QStringList files;
+    for(const QString &file : getDirFiles(path)) {
+        MediaMode mode;
+        if(classify(file, mode) && mode != MediaMode::Video) {
+            files << QDir(path).filePath(file);
+        }
+    }
+
+    PreviewStore &store { PreviewStore::instance() };
+    QAtomicInt done {0};
+
+    QtConcurrent::blockingMap(files, [&](const QString &file) {
+        const QFileInfo info(file);
+        if(!store.find(info, previewSize).isNull() && !store.find(info, thumbSize).isNull()) {
+            return;
+        }
+
+        // animations are played, not previewed: only their first frame makes a thumbnail.
+        // huge pictures are tiled in the viewer and never come from the store
+        DecodedImage decoded { ImageCache::decode(file, previewSize, true) };
+        const bool animated { decoded.animated };
+        if(animated) {
+            decoded = ImageCache::decode(file, thumbSize);
+        }
+        if(decoded.image.isNull()) {
+            qDebug() << "cannot prewarm" << file << decoded.error;
+            return;
+        }
+        if(!animated && !decoded.tiled) {
+            store.insert(info, previewSize, decoded.image, decoded.fullSize);
+        }
+
+        const QImage image { toDisplayFormat(decoded.image) };
+        const QSize fitted { image.size().scaled(thumbSize, Qt::KeepAspectRatio).boundedTo(image.size()) };
+        store.insert(info, thumbSize, resample(image, fitted, ResampleFilter::Area), decoded.fullSize);
+        done.fetchAndAddRelaxed(1);
+    });
+
+    qDebug() << "prewarmed" << done.load() << "of" << files.size() << "files in" << path;
+    return 0;
+}
+
+} // namespace pork
@@ -0,0 +1,92 @@
+#ifndef PREVIEWSTORE_H
+#define PREVIEWSTORE_H
+
+#include <QImage>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+#include <QSharedPointer>
+
+namespace pork {
+
+//! Persistent cache of screen sized previews and thumbnails shared by all application runs.
+//! Pixels are stored raw in a pack file and handed out as memory mapped images,
+//! so a hit costs neither decoding nor copying. Entries are keyed by path, file size, mtime and box size.
+//! Least recently used entries are dropped by pack compaction once it grows over the cap.
+//! Pack writes and compaction run outside of the store lock, so lookups from the gui thread never wait for disk.
+class PreviewStore
+{
+public:
+    static PreviewStore &instance();
+    ~PreviewStore();
+
+    //! Returns null image if there is no entry. Returned image refers to the pack directly
+    QImage find(const QFileInfo &info, const QSize &box, QSize *fullSize = nullptr);
+    void insert(const QFileInfo &info, const QSize &box, const QImage &image, const QSize &fullSize);
+
+private:
+    struct Entry
+    {
+        qint64 offset;
+        qint32 width;
+        qint32 height;
+        qint32 bytesPerLine;
+        qint32 format;
+        QSize fullSize;
+        quint64 used; //! LRU clock value of the last access
+
+        qint64 size() const { return static_cast<qint64>(bytesPerLine)*height; }
+    };
+
+    //! Pack file outlives the store while any of its images is alive.
+    //! Compacted pack is removed with its last image, mapped files cannot be removed on Windows
+    struct Pack
+    {
+        ~Pack();
+
+        QFile file;
+        QMutex mutex; //! guards `file`: writes, maps and unmaps
+        quint32 generation {0};
+        bool obsolete {false};
+    };
+
+    struct Mapping
+    {
+        QSharedPointer<Pack> pack;
+        uchar *data;
+    };
+
+    PreviewStore();
+
+    static QByteArray key(const QFileInfo &info, const QSize &box);
+    static void unmap(void *mapping);
+
+    QString packPath(quint32 generation) const;
+    QString indexPath() const;
+    QSharedPointer<Pack> openPack(quint32 generation, bool truncate) const;
+    void load();
+    void save();
+    void compact(qint64 incoming);
+
+    QString m_dir;
+    QMutex m_mutex;
+    QHash<QByteArray, Entry> m_entries;
+    QSet<QByteArray> m_writing; //! entries whose pixels are being written
+    QSharedPointer<Pack> m_pack;
+    quint32 m_generation {0};
+    qint64 m_packSize {0}; //! end of written data. dead entries are inside until compaction
+    quint64 m_clock {0};
+    int m_unsaved {0};
+    bool m_compacting {false};
+    QThreadPool m_pool; //! compaction
+};
+
+//! Fills the store with previews and thumbnails of directory pictures. Returns process exit code
+int prewarm(const QString &path);
+
+} // namespace pork
+
+#endif // PREVIEWSTORE_H
@@ -0,0 +1,426 @@
+#include "resampler.h"
+#include "config.h"
+#include "trace.h"
+
+#include <QtConcurrent>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PORK_RESAMPLE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(PORK_RESAMPLE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PORK_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define PORK_TARGET_AVX2
+#endif
+
+namespace pork {
+
+namespace {
+
+enum class Simd
+{
+    None = 0,
+    Sse2,
+    Avx2,
+};
+
+Simd detectSimd()
+{
+#if defined(PORK_RESAMPLE_X86)
+#if defined(_MSC_VER)
+    int info[4] {};
+    __cpuid(info, 1);
+    const bool osxsave { (info[2] & (1 << 27)) != 0 };
+    const bool fma { (info[2] & (1 << 12)) != 0 };
+    const bool ymmEnabled { osxsave && (_xgetbv(0) & 0x6) == 0x6 };
+    __cpuidex(info, 7, 0);
+    const bool avx2 { (info[1] & (1 << 5)) != 0 };
+    return avx2 && fma && ymmEnabled ? Simd::Avx2 : Simd::Sse2;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? Simd::Avx2 : Simd::Sse2;
+#endif
+#else
+    return Simd::None;
+#endif
+}
+
+Simd simd()
+{
+    static const Simd res { detectSimd() };
+    return res;
+}
+
+//! Weights of source pixels contributing to every destination pixel of one axis.
+//! Each destination pixel has exactly `taps` weights, padded with zeros.
+struct Contributions
+{
+    int taps {0};
+    std::vector<int> first;     //! index of the first contributing source pixel
+    std::vector<float> weights; //! `taps` weights per destination pixel
+};
+
+float bicubic(float x)
+{
+    // Catmull-Rom spline
+    x = std::abs(x);
+    if(x < 1.0f) {
+        return 1.5f*x*x*x - 2.5f*x*x + 1.0f;
+    }
+    if(x < 2.0f) {
+        return -0.5f*x*x*x + 2.5f*x*x - 4.0f*x + 2.0f;
+    }
+    return 0.0f;
+}
+
+float lanczos3(float x)
+{
+    constexpr float pi {3.14159265358979f};
+    x = std::abs(x);
+    if(x < 1e-6f) {
+        return 1.0f;
+    }
+    if(x >= 3.0f) {
+        return 0.0f;
+    }
+    const float px { pi*x };
+    return 3.0f*std::sin(px)*std::sin(px/3.0f)/(px*px);
+}
+
+//! `start` and `length` define source span in source pixels, `srcSize` is used for edge clamping
+Contributions contributions(qreal start, qreal length, int srcSize, int dstSize, ResampleFilter filter)
+{
+    const qreal scale { dstSize/length };
+    if(filter == ResampleFilter::Auto) {
+        filter = scale < 1.0 ? ResampleFilter::Area : ResampleFilter::Bicubic;
+    }
+
+    // raw weights per destination pixel: source index and weight
+    std::vector<std::vector<std::pair<int, float>>> raw(static_cast<size_t>(dstSize));
+
+    for(int i = 0; i < dstSize; ++i) {
+        auto &pixel { raw[static_cast<size_t>(i)] };
+
+        if(filter == ResampleFilter::Area) {
+            // overlap of source pixels with the destination pixel footprint
+            const qreal a { start + i/scale };
+            const qreal b { start + (i + 1)/scale };
+            for(int j = static_cast<int>(std::floor(a)); j < std::ceil(b); ++j) {
+                const qreal w { std::min<qreal>(b, j + 1) - std::max<qreal>(a, j) };
+                if(w > 0) {
+                    pixel.emplace_back(j, static_cast<float>(w));
+                }
+            }
+        } else {
+            const qreal radius { filter == ResampleFilter::Bicubic ? 2.0 : 3.0 };
+            const qreal kernelScale { std::min<qreal>(scale, 1.0) }; // kernel is stretched when downscaling
+            const qreal support { radius/kernelScale };
+            const qreal center { start + (i + 0.5)/scale };
+            for(int j = static_cast<int>(std::floor(center - support)); j <= std::ceil(center + support); ++j) {
+                const float x { static_cast<float>((j + 0.5 - center)*kernelScale) };
+                const float w { filter == ResampleFilter::Bicubic ? bicubic(x) : lanczos3(x) };
+                if(w != 0.0f) {
+                    pixel.emplace_back(j, w);
+                }
+            }
+        }
+
+        if(pixel.empty()) {
+            // degenerate span. nearest pixel then
+            pixel.emplace_back(static_cast<int>(std::floor(start + (i + 0.5)/scale)), 1.0f);
+        }
+    }
+
+    Contributions res;
+    for(const auto &pixel : raw) {
+        const int clampedFirst { qBound(0, pixel.front().first, srcSize - 1) };
+        const int clampedLast { qBound(0, pixel.back().first, srcSize - 1) };
+        res.taps = std::max(res.taps, clampedLast - clampedFirst + 1);
+    }
+    res.taps = std::min(res.taps, srcSize);
+
+    res.first.resize(static_cast<size_t>(dstSize));
+    res.weights.assign(static_cast<size_t>(dstSize)*res.taps, 0.0f);
+
+    for(int i = 0; i < dstSize; ++i) {
+        const auto &pixel { raw[static_cast<size_t>(i)] };
+        const int first { std::min(qBound(0, pixel.front().first, srcSize - 1), srcSize - res.taps) };
+        res.first[static_cast<size_t>(i)] = first;
+
+        // out of range pixels are folded to the edge ones
+        float sum {0.0f};
+        float *weights { &res.weights[static_cast<size_t>(i)*res.taps] };
+        for(const auto &contribution : pixel) {
+            weights[qBound(0, contribution.first, srcSize - 1) - first] += contribution.second;
+            sum += contribution.second;
+        }
+
+        if(sum != 0.0f) {
+            for(int k = 0; k < res.taps; ++k) {
+                weights[k] /= sum;
+            }
+        }
+    }
+
+    return res;
+}
+
+//! horizontal pass: one row of 8-bit pixels into one row of float pixels
+
+void horizontalScalar(const uchar *src, const Contributions &c, float *dst, int dstWidth)
+{
+    for(int i = 0; i < dstWidth; ++i) {
+        const float *w { &c.weights[static_cast<size_t>(i)*c.taps] };
+        const uchar *p { src + 4*c.first[static_cast<size_t>(i)] };
+        float acc[4] {};
+        for(int k = 0; k < c.taps; ++k) {
+            for(int ch = 0; ch < 4; ++ch) {
+                acc[ch] += w[k]*p[4*k + ch];
+            }
+        }
+        std::memcpy(dst + 4*i, acc, sizeof(acc));
+    }
+}
+
+//! vertical pass: `taps` rows of float pixels into one row of 8-bit pixels
+
+void verticalScalar(const float *const *rows, const float *w, int taps, uchar *dst, int width)
+{
+    for(int x = 0; x < 4*width; x += 4) {
+        float acc[4] {};
+        for(int k = 0; k < taps; ++k) {
+            for(int ch = 0; ch < 4; ++ch) {
+                acc[ch] += w[k]*rows[k][x + ch];
+            }
+        }
+
+        // premultiplied color can't exceed alpha, filter overshoots are clamped
+        const float alpha { qBound(0.0f, acc[3], 255.0f) };
+        for(int ch = 0; ch < 3; ++ch) {
+            dst[x + ch] = static_cast<uchar>(qBound(0.0f, acc[ch], alpha) + 0.5f);
+        }
+        dst[x + 3] = static_cast<uchar>(alpha + 0.5f);
+    }
+}
+
+#if defined(PORK_RESAMPLE_X86)
+
+void horizontalSse2(const uchar *src, const Contributions &c, float *dst, int dstWidth)
+{
+    const __m128i zero { _mm_setzero_si128() };
+    for(int i = 0; i < dstWidth; ++i) {
+        const float *w { &c.weights[static_cast<size_t>(i)*c.taps] };
+        const uchar *p { src + 4*c.first[static_cast<size_t>(i)] };
+        __m128 acc { _mm_setzero_ps() };
+        for(int k = 0; k < c.taps; ++k) {
+            int pixel;
+            std::memcpy(&pixel, p + 4*k, sizeof(pixel));
+            const __m128i wide { _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero) };
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_cvtepi32_ps(wide), _mm_set1_ps(w[k])));
+        }
+        _mm_storeu_ps(dst + 4*i, acc);
+    }
+}
+
+inline int packPixelSse2(__m128 acc)
+{
+    acc = _mm_min_ps(_mm_max_ps(acc, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    acc = _mm_min_ps(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(3, 3, 3, 3)));
+    __m128i v { _mm_cvtps_epi32(acc) };
+    v = _mm_packs_epi32(v, v);
+    v = _mm_packus_epi16(v, v);
+    return _mm_cvtsi128_si32(v);
+}
+
+void verticalSse2(const float *const *rows, const float *w, int taps, uchar *dst, int width)
+{
+    for(int x = 0; x < width; ++x) {
+        __m128 acc { _mm_setzero_ps() };
+        for(int k = 0; k < taps; ++k) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(rows[k] + 4*x), _mm_set1_ps(w[k])));
+        }
+        const int pixel { packPixelSse2(acc) };
+        std::memcpy(dst + 4*x, &pixel, sizeof(pixel));
+    }
+}
+
+PORK_TARGET_AVX2
+void horizontalAvx2(const uchar *src, const Contributions &c, float *dst, int dstWidth)
+{
+    for(int i = 0; i < dstWidth; ++i) {
+        const float *w { &c.weights[static_cast<size_t>(i)*c.taps] };
+        const uchar *p { src + 4*c.first[static_cast<size_t>(i)] };
+
+        // two source pixels per step
+        __m256 acc { _mm256_setzero_ps() };
+        int k {0};
+        for(; k + 1 < c.taps; k += 2) {
+            const __m128i pixels { _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + 4*k)) };
+            const __m256 wide { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(pixels)) };
+            const __m256 weights { _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(w[k])), _mm_set1_ps(w[k + 1]), 1) };
+            acc = _mm256_fmadd_ps(wide, weights, acc);
+        }
+
+        __m128 sum { _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1)) };
+        if(k < c.taps) {
+            int pixel;
+            std::memcpy(&pixel, p + 4*k, sizeof(pixel));
+            const __m128 wide { _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(pixel))) };
+            sum = _mm_fmadd_ps(wide, _mm_set1_ps(w[k]), sum);
+        }
+        _mm_storeu_ps(dst + 4*i, sum);
+    }
+}
+
+PORK_TARGET_AVX2
+void verticalAvx2(const float *const *rows, const float *w, int taps, uchar *dst, int width)
+{
+    const __m256 zero { _mm256_setzero_ps() };
+    const __m256 max { _mm256_set1_ps(255.0f) };
+
+    // two destination pixels per step
+    int x {0};
+    for(; x + 1 < width; x += 2) {
+        __m256 acc { _mm256_setzero_ps() };
+        for(int k = 0; k < taps; ++k) {
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(rows[k] + 4*x), _mm256_set1_ps(w[k]), acc);
+        }
+
+        acc = _mm256_min_ps(_mm256_max_ps(acc, zero), max);
+        acc = _mm256_min_ps(acc, _mm256_permute_ps(acc, _MM_SHUFFLE(3, 3, 3, 3)));
+        __m256i v { _mm256_cvtps_epi32(acc) };
+        v = _mm256_packs_epi32(v, v);
+        v = _mm256_packus_epi16(v, v);
+
+        const int first { _mm_cvtsi128_si32(_mm256_castsi256_si128(v)) };
+        const int second { _mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1)) };
+        std::memcpy(dst + 4*x, &first, sizeof(first));
+        std::memcpy(dst + 4*x + 4, &second, sizeof(second));
+    }
+
+    if(x < width) {
+        __m128 acc { _mm_setzero_ps() };
+        for(int k = 0; k < taps; ++k) {
+            acc = _mm_fmadd_ps(_mm_loadu_ps(rows[k] + 4*x), _mm_set1_ps(w[k]), acc);
+        }
+        const int pixel { packPixelSse2(acc) };
+        std::memcpy(dst + 4*x, &pixel, sizeof(pixel));
+    }
+}
+
+#endif // PORK_RESAMPLE_X86
+
+struct Kernels
+{
+    void (*horizontal)(const uchar *, const Contributions &, float *, int);
+    void (*vertical)(const float *const *, const float *, int, uchar *, int);
+};
+
+Kernels kernels()
+{
+    switch(simd()) {
+#if defined(PORK_RESAMPLE_X86)
+        case Simd::Avx2: return { horizontalAvx2, verticalAvx2 };
+        case Simd::Sse2: return { horizontalSse2, verticalSse2 };
+#endif
+        default: return { horizontalScalar, verticalScalar };
+    }
+}
+
+//! Resamples destination rows `[y0, y1)`. Only source rows contributing to them are filtered horizontally.
+void resampleRows(const uchar *src, qsizetype srcStride, uchar *dst, qsizetype dstStride, int dstWidth,
+                  const Contributions &h, const Contributions &v, int y0, int y1)
+{
+    const Kernels k { kernels() };
+
+    int rowMin { v.first[static_cast<size_t>(y0)] };
+    int rowMax { rowMin };
+    for(int y = y0; y < y1; ++y) {
+        rowMin = std::min(rowMin, v.first[static_cast<size_t>(y)]);
+        rowMax = std::max(rowMax, v.first[static_cast<size_t>(y)] + v.taps);
+    }
+
+    const size_t rowLength { static_cast<size_t>(dstWidth)*4 };
+    std::vector<float> filtered(static_cast<size_t>(rowMax - rowMin)*rowLength);
+    for(int row = rowMin; row < rowMax; ++row) {
+        k.horizontal(src + row*srcStride, h, &filtered[static_cast<size_t>(row - rowMin)*rowLength], dstWidth);
+    }
+
+    std::vector<const float *> rows(static_cast<size_t>(v.taps));
+    for(int y = y0; y < y1; ++y) {
+        const int first { v.first[static_cast<size_t>(y)] };
+        for(int i = 0; i < v.taps; ++i) {
+            rows[static_cast<size_t>(i)] = &filtered[static_cast<size_t>(first + i - rowMin)*rowLength];
+        }
+        k.vertical(rows.data(), &v.weights[static_cast<size_t>(y)*v.taps], v.taps, dst + y*dstStride, dstWidth);
+    }
+}
+
+} // namespace
+
+QImage resample(const QImage &image, const QRectF &source, const QSize &size, ResampleFilter filter)
+{
+    if(image.isNull() || size.isEmpty() || source.isEmpty()) {
+        return QImage();
+    }
+
+    PORK_TRACE("resample");
+
+    QImage src { image };
+    if(src.format() != QImage::Format_ARGB32_Premultiplied && src.format() != QImage::Format_RGB32) {
+        src = src.convertToFormat(src.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    }
+
+    const Contributions h { contributions(source.x(), source.width(), src.width(), size.width(), filter) };
+    const Contributions v { contributions(source.y(), source.height(), src.height(), size.height(), filter) };
+
+    QImage res(size, src.format());
+    const uchar *srcBits { src.constBits() };
+    const qsizetype srcStride { src.bytesPerLine() };
+    uchar *dstBits { res.bits() };
+    const qsizetype dstStride { res.bytesPerLine() };
+
+    // small pictures aren't worth thread synchronization
+    if(static_cast<qint64>(size.width())*size.height() < tune::resample::parallelThreshold) {
+        resampleRows(srcBits, srcStride, dstBits, dstStride, size.width(), h, v, 0, size.height());
+        return res;
+    }
+
+    QVector<int> strips;
+    for(int y = 0; y < size.height(); y += tune::resample::stripRows) {
+        strips << y;
+    }
+
+    QtConcurrent::blockingMap(strips, [&](int y0) {
+        const int y1 { std::min(y0 + tune::resample::stripRows, size.height()) };
+        resampleRows(srcBits, srcStride, dstBits, dstStride, size.width(), h, v, y0, y1);
+    });
+
+    return res;
+}
+
+QImage resample(const QImage &image, const QSize &size, ResampleFilter filter)
+{
+    return resample(image, QRectF(image.rect()), size, filter);
+}
+
+const char *resampleKernel()
+{
+    switch(simd()) {
+        case Simd::Avx2: return "avx2";
+        case Simd::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+} // namespace pork
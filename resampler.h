@@ -0,0 +1,27 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QImage>
+
+namespace pork {
+
+enum class ResampleFilter
+{
+    Auto = 0, //! area average for downscaling, bicubic for upscaling
+    Area,
+    Bicubic,
+    Lanczos3,
+};
+
+//! Resamples `source` area of `image` to `size` with a separable filter.
+//! Rows are processed in parallel strips, SSE2/AVX2 kernels are picked at runtime.
+//! `Format_ARGB32_Premultiplied` and `Format_RGB32` are processed as is, other formats are converted first.
+QImage resample(const QImage &image, const QRectF &source, const QSize &size, ResampleFilter filter = ResampleFilter::Auto);
+QImage resample(const QImage &image, const QSize &size, ResampleFilter filter = ResampleFilter::Auto);
+
+//! Name of the kernels used by `resample` on this CPU
+const char *resampleKernel();
+
+} // namespace pork
+
+#endif // RESAMPLER_H
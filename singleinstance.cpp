@@ -0,0 +1,100 @@
+#include "singleinstance.h"
+#include "config.h"
+
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QCoreApplication>
+#include <QDebug>
+
+namespace pork {
+
+SingleInstance::SingleInstance(QObject *parent)
+    : QObject(parent)
+{
+    // per user, so that users of one machine do not share a window
+    QString user { qEnvironmentVariable("USER") };
+    if(user.isEmpty()) {
+        user = qEnvironmentVariable("USERNAME");
+    }
+    m_name = QStringLiteral("%1-%2").arg(QCoreApplication::applicationName(), user);
+
+    connect(&m_server, &QLocalServer::newConnection, this, [this]() {
+        while(QLocalSocket *socket = m_server.nextPendingConnection()) {
+            connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+            connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+                readFiles(socket);
+            });
+        }
+    });
+}
+
+bool SingleInstance::forward(const QStringList &files)
+{
+    QLocalSocket socket;
+    socket.connectToServer(m_name);
+    if(!socket.waitForConnected(tune::instance::timeout)) {
+        return false;
+    }
+
+    QDataStream stream(&socket);
+    stream << files;
+    if(!socket.waitForBytesWritten(tune::instance::timeout)) {
+        qDebug() << "cannot forward files to running instance:" << socket.errorString();
+        return false;
+    }
+
+    socket.disconnectFromServer();
+    return true;
+}
+
+bool SingleInstance::listen()
+{
+    // other users of the machine must not make this viewer open files
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+
+    if(m_server.listen(m_name)) {
+        return true;
+    }
+
+    // socket file left by crashed instance. a live one belongs to the instance started at the same time
+    if(m_server.serverError() == QAbstractSocket::AddressInUseError && !isRunning()) {
+        QLocalServer::removeServer(m_name);
+        if(m_server.listen(m_name)) {
+            return true;
+        }
+    }
+
+    qDebug() << "single instance server is not started:" << m_server.errorString();
+    return false;
+}
+
+bool SingleInstance::isRunning() const
+{
+    QLocalSocket socket;
+    socket.connectToServer(m_name);
+    if(!socket.waitForConnected(tune::instance::timeout)) {
+        return false;
+    }
+
+    socket.disconnectFromServer();
+    return true;
+}
+
+void SingleInstance::readFiles(QLocalSocket *socket)
+{
+    QDataStream stream(socket);
+    stream.startTransaction();
+
+    QStringList files;
+    stream >> files;
+
+    // wait for the rest of the list
+    if(!stream.commitTransaction()) {
+        return;
+    }
+
+    emit filesReceived(files);
+    socket->disconnectFromServer();
+}
+
+} // namespace pork
@@ -0,0 +1,36 @@
+#ifndef SINGLEINSTANCE_H
+#define SINGLEINSTANCE_H
+
+#include <QObject>
+#include <QLocalServer>
+
+namespace pork {
+
+//! Keeps one running application per user. Next launches forward their files
+//! to the running one over a local socket and quit.
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SingleInstance(QObject *parent = 0);
+
+    //! Passes files to already running instance. Returns false if there is none
+    bool forward(const QStringList &files);
+    //! Returns false if the server is not started, e.g. another instance has just started its own
+    bool listen();
+
+signals:
+    void filesReceived(const QStringList &files);
+
+private:
+    bool isRunning() const;
+    void readFiles(QLocalSocket *socket);
+
+    QString m_name;
+    QLocalServer m_server;
+};
+
+} // namespace pork
+
+#endif // SINGLEINSTANCE_H
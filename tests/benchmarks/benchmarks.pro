@@ -0,0 +1,49 @@
+#-------------------------------------------------
+#
+# Performance benchmarks of the viewer pipeline.
+# Machine readable results: benchmarks -o results.csv,csv or -o results.xml,xml
+#
+#-------------------------------------------------
+
+QT       += core gui widgets concurrent testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = benchmarks
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+ROOT = $$PWD/../..
+INCLUDEPATH += $$ROOT
+
+SOURCES += \
+    tst_benchmarks.cpp \
+    $$ROOT/benchmark.cpp \
+    $$ROOT/classifier.cpp \
+    $$ROOT/dirindex.cpp \
+    $$ROOT/filesource.cpp \
+    $$ROOT/imagecache.cpp \
+    $$ROOT/imageview.cpp \
+    $$ROOT/previewstore.cpp \
+    $$ROOT/resampler.cpp \
+    $$ROOT/tiledimage.cpp \
+    $$ROOT/trace.cpp \
+    $$ROOT/utils.cpp \
+    $$ROOT/watchdog.cpp
+
+HEADERS += \
+    $$ROOT/benchmark.h \
+    $$ROOT/classifier.h \
+    $$ROOT/config.h \
+    $$ROOT/dirindex.h \
+    $$ROOT/filesource.h \
+    $$ROOT/imagecache.h \
+    $$ROOT/imageview.h \
+    $$ROOT/previewstore.h \
+    $$ROOT/resampler.h \
+    $$ROOT/tiledimage.h \
+    $$ROOT/trace.h \
+    $$ROOT/utils.h \
+    $$ROOT/watchdog.h
@@ -0,0 +1,293 @@
+#include "config.h"
+#include "benchmark.h"
+#include "utils.h"
+#include "classifier.h"
+#include "imagecache.h"
+#include "imageview.h"
+#include "dirindex.h"
+
+#include <QtTest>
+#include <QApplication>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QDir>
+#include <QFile>
+
+using namespace pork;
+
+namespace {
+
+QStringList wildcards()
+{
+    QStringList res;
+    for(const QString &format : cap::supportedImages() + cap::supportedGif()) {
+        res << QStringLiteral("*.") + format;
+    }
+    for(const auto &format : cap::supportedVideo) {
+        res << QStringLiteral("*.") + QString::fromLatin1(format.data(), static_cast<int>(format.size()));
+    }
+    return res;
+}
+
+void loadIndex(DirIndex &index, const QString &path)
+{
+    index.setPath(path);
+    while(index.isLoading()) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+}
+
+} // namespace
+
+//! Former Qt-only paths against the viewer ones on a synthetic corpus: 12 MP pictures and a big directory.
+//! Every case has a `qt` row and a `pork` row. Results go out as CSV or XML with `-o file,csv` or `-o file,xml`
+class Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void decode_data();
+    void decode();
+    void scale_data();
+    void scale();
+    void listDir_data();
+    void listDir();
+    void stepDir_data();
+    void stepDir();
+    void classify_data();
+    void classify();
+
+private:
+    QTemporaryDir m_corpus;
+    QString m_dirPath;
+    QImage m_image;
+    QSize m_screenSize {1920, 1080}; //! the usual full hd viewer. offscreen screen is too small to be representative
+};
+
+void Benchmarks::initTestCase()
+{
+    QVERIFY2(m_corpus.isValid(), qPrintable(m_corpus.errorString()));
+    const QDir dir { m_corpus.path() };
+
+    // every format Qt can write here. stock Qt has no GIF writer, its cases are skipped then
+    m_image = syntheticImage(QSize(4000, 3000));
+    const QList<QByteArray> writable { QImageWriter::supportedImageFormats() };
+    for(const char *format : {"jpg", "png", "webp", "gif"}) {
+        if(writable.contains(format)) {
+            QVERIFY(m_image.save(dir.filePath(QStringLiteral("corpus.%1").arg(format)), format, 90));
+        }
+    }
+
+    // files are empty, only names matter for listing, navigation and classification
+    const char *extensions[] { "jpg", "png", "gif", "webp", "mp4", "txt" };
+    QVERIFY(dir.mkdir("dir"));
+    const QDir sub { dir.filePath("dir") };
+    for(int i = 0; i < tune::benchmark::dirEntries; ++i) {
+        QFile(sub.filePath(QStringLiteral("file_%1.%2").arg(i, 5, 10, QChar('0')).arg(QLatin1String(extensions[i % 6])))).open(QIODevice::WriteOnly);
+    }
+    m_dirPath = sub.path();
+}
+
+void Benchmarks::decode_data()
+{
+    QTest::addColumn<QString>("format");
+    QTest::addColumn<bool>("viewer");
+
+    for(const char *format : {"jpg", "png", "webp", "gif"}) {
+        QTest::addRow("%s/qt", format) << QString(format) << false;
+        QTest::addRow("%s/pork", format) << QString(format) << true;
+    }
+}
+
+//! Full resolution decode by plain reader against fitted decode through the shared mapping
+void Benchmarks::decode()
+{
+    QFETCH(QString, format);
+    QFETCH(bool, viewer);
+
+    const QString file { QDir(m_corpus.path()).filePath(QStringLiteral("corpus.") + format) };
+    if(!QFile::exists(file)) {
+        QSKIP(qPrintable(QStringLiteral("no %1 writer to make the sample").arg(format)));
+    }
+
+    const QSize fitSize { m_screenSize - QSize(tune::screen::reserve, tune::screen::reserve) };
+    if(viewer) {
+        QBENCHMARK {
+            ImageCache::decode(file, fitSize);
+        }
+    } else {
+        QBENCHMARK {
+            const QImage image { QImageReader(file).read() };
+            Q_UNUSED(image)
+        }
+    }
+}
+
+void Benchmarks::scale_data()
+{
+    QTest::addColumn<QString>("variant");
+
+    QTest::newRow("qt") << QString("qt");
+    QTest::newRow("pork/first") << QString("first");
+    QTest::newRow("pork/cached") << QString("cached");
+}
+
+//! Picture on a screen: scaled pixmap as it was done before against visible tiles of `ImageView`.
+//! Cached case zooms back to the scale already seen
+void Benchmarks::scale()
+{
+    QFETCH(QString, variant);
+
+    const QSize fit { m_image.size().scaled(m_screenSize, Qt::KeepAspectRatio) };
+    const qreal scale { static_cast<qreal>(fit.width())/m_image.width() };
+    QImage target(m_screenSize, QImage::Format_ARGB32_Premultiplied);
+
+    if(variant == "qt") {
+        QBENCHMARK {
+            const QPixmap pixmap { QPixmap::fromImage(m_image.scaled(fit, Qt::KeepAspectRatio, Qt::SmoothTransformation)) };
+            QPainter painter(&target);
+            painter.drawPixmap(0, 0, pixmap);
+        }
+        return;
+    }
+
+    ImageView view;
+    view.resize(m_screenSize);
+
+    if(variant == "first") {
+        QBENCHMARK {
+            view.setImage(m_image);
+            view.setScale(scale);
+            view.render(&target);
+        }
+        return;
+    }
+
+    view.setImage(m_image);
+    view.setScale(scale);
+    view.render(&target);
+    QBENCHMARK {
+        view.setScale(1.0);
+        view.setScale(scale);
+        view.render(&target);
+    }
+}
+
+void Benchmarks::listDir_data()
+{
+    QTest::addColumn<bool>("viewer");
+
+    QTest::newRow("qt") << false;
+    QTest::newRow("pork") << true;
+}
+
+//! Listing with stat-ing `QDir` against streamed `DirIndex`
+void Benchmarks::listDir()
+{
+    QFETCH(bool, viewer);
+
+    if(viewer) {
+        QBENCHMARK {
+            DirIndex index;
+            loadIndex(index, m_dirPath);
+        }
+    } else {
+        const QStringList filters { wildcards() };
+        QBENCHMARK {
+            const QFileInfoList files { QDir(m_dirPath).entryInfoList(filters, QDir::Files, QDir::Name) };
+            Q_UNUSED(files)
+        }
+    }
+}
+
+void Benchmarks::stepDir_data()
+{
+    listDir_data();
+}
+
+//! Stepping through the whole directory: `indexOf` in a listing against `DirIndex` neighbours
+void Benchmarks::stepDir()
+{
+    QFETCH(bool, viewer);
+
+    if(viewer) {
+        DirIndex index;
+        loadIndex(index, m_dirPath);
+        QVERIFY(!index.isEmpty());
+
+        QBENCHMARK {
+            QString file { index.at(0) };
+            for(int i = 0; i < index.size(); ++i) {
+                file = index.neighbour(file, Direction::Forward);
+            }
+        }
+    } else {
+        const QStringList files { QDir(m_dirPath).entryList(wildcards(), QDir::Files, QDir::Name) };
+        QVERIFY(!files.isEmpty());
+
+        QBENCHMARK {
+            QString file { files.first() };
+            for(int i = 0; i < files.size(); ++i) {
+                file = files[(files.indexOf(file) + 1) % files.size()];
+            }
+        }
+    }
+}
+
+void Benchmarks::classify_data()
+{
+    listDir_data();
+}
+
+//! Wildcard matching as extension check was done before against `classify`
+void Benchmarks::classify()
+{
+    QFETCH(bool, viewer);
+
+    const QStringList filters { wildcards() };
+    const QStringList names { QDir(m_dirPath).entryList(QDir::Files) };
+
+    int expected {0};
+    for(const QString &name : names) {
+        expected += QDir::match(filters, name) ? 1 : 0;
+    }
+
+    int hits {0};
+    if(viewer) {
+        QBENCHMARK {
+            hits = 0;
+            MediaMode mode;
+            for(const QString &name : names) {
+                hits += pork::classify(name, mode) ? 1 : 0;
+            }
+        }
+    } else {
+        QBENCHMARK {
+            hits = 0;
+            for(const QString &name : names) {
+                hits += QDir::match(filters, name) ? 1 : 0;
+            }
+        }
+    }
+
+    QCOMPARE(hits, expected);
+}
+
+// `QTEST_MAIN` would pick the platform of the environment. no window is shown, so timings must not depend on a display server
+int main(int argc, char *argv[])
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    app.setAttribute(Qt::AA_Use96Dpi, true);
+    QTEST_SET_MAIN_SOURCE_PATH
+
+    Benchmarks benchmarks;
+    return QTest::qExec(&benchmarks, argc, argv);
+}
+
+#include "tst_benchmarks.moc"
@@ -0,0 +1,317 @@
+#include "thumbnailer.h"
+#include "config.h"
+#include "classifier.h"
+#include "imagecache.h"
+#include "previewstore.h"
+
+#include <QImageReader>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
+#include <QDebug>
+
+#include <VLCQtCore/Instance.h>
+#include <VLCQtCore/MediaPlayer.h>
+#include <VLCQtCore/Media.h>
+#include <VLCQtCore/Video.h>
+
+namespace pork {
+
+Thumbnailer::Thumbnailer(QObject *parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(tune::grid::threads);
+    m_thumbnails.setMaxCost(tune::grid::memoryCap*1024);
+
+    m_videoTimer.setSingleShot(true);
+    connect(&m_videoTimer, &QTimer::timeout, this, [this]() {
+        qDebug() << "video thumbnail timeout:" << m_videoFile;
+        finishVideo(true);
+    });
+
+    connect(&m_vlcWatcher, &QFutureWatcher<VlcInstance *>::finished, this, [this]() {
+        initVideo();
+        nextVideo();
+    });
+}
+
+Thumbnailer::~Thumbnailer()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_queue.clear();
+    }
+    m_pool.waitForDone();
+
+    // loaded instance nobody has taken yet
+    if(!m_vlc && m_vlcLoading) {
+        m_vlcWatcher.waitForFinished();
+        if(m_vlcWatcher.future().resultCount() > 0) {
+            delete m_vlcWatcher.result();
+        }
+    }
+}
+
+void Thumbnailer::setSize(const QSize &size)
+{
+    if(size == m_size) {
+        return;
+    }
+
+    {
+        // jobs in progress are still delivered, but dropped as ones of the old size
+        QMutexLocker lock(&m_mutex);
+        m_size = size;
+        m_queue.clear();
+    }
+    m_videoQueue.clear();
+    m_thumbnails.clear();
+    m_pending.clear();
+}
+
+QImage Thumbnailer::thumbnail(const QString &file)
+{
+    if(QImage *cached = m_thumbnails.object(file)) {
+        return *cached;
+    }
+
+    if(m_pending.contains(file)) {
+        return QImage();
+    }
+
+    MediaMode mode;
+    if(!classify(file, mode)) {
+        return QImage();
+    }
+
+    // videos go through the workers too: the store is checked there before libvlc is bothered
+    QMutexLocker lock(&m_mutex);
+    m_pending.insert(file);
+    m_queue.prepend(file);
+
+    // thumbnails user has scrolled away from are dropped
+    while(m_queue.size() > tune::grid::queueSize) {
+        m_pending.remove(m_queue.takeLast());
+    }
+
+    if(m_workers < m_pool.maxThreadCount()) {
+        ++m_workers;
+        QtConcurrent::run(&m_pool, [this]() { work(); });
+    }
+
+    return QImage();
+}
+
+void Thumbnailer::work()
+{
+    forever {
+        QString file;
+        QSize size;
+        {
+            QMutexLocker lock(&m_mutex);
+            if(m_queue.isEmpty()) {
+                --m_workers;
+                return;
+            }
+            file = m_queue.takeFirst();
+            size = m_size;
+        }
+
+        const QFileInfo info(file);
+        QImage image { PreviewStore::instance().find(info, size) };
+        const bool stored { !image.isNull() };
+
+        MediaMode mode;
+        classify(file, mode);
+
+        if(!stored && mode == MediaMode::Video) {
+            QMetaObject::invokeMethod(this, [this, file, size]() {
+                if(size == m_size) {
+                    requestVideo(file);
+                }
+            }, Qt::QueuedConnection);
+            continue;
+        }
+
+        // decoders supporting scaled reading never produce the full picture
+        if(!stored) {
+            image = toDisplayFormat(ImageCache::decode(file, size).image);
+        }
+
+        deliver(file, image, size, !stored);
+    }
+}
+
+void Thumbnailer::deliver(const QString &file, const QImage &image, const QSize &size, bool store)
+{
+    QImage fitted { image };
+    if(!fitted.isNull() && (fitted.width() > size.width() || fitted.height() > size.height())) {
+        fitted = fitted.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    // painted as is, without conversion on every paint
+    fitted = toDisplayFormat(fitted);
+
+    if(store) {
+        PreviewStore::instance().insert(QFileInfo(file), size, fitted, image.size());
+    }
+
+    QMetaObject::invokeMethod(this, [this, file, fitted, size]() {
+        if(size == m_size) {
+            insert(file, fitted);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void Thumbnailer::insert(const QString &file, const QImage &image)
+{
+    // broken files are cached as well so they are not requested over and over
+    m_pending.remove(file);
+
+    m_thumbnails.insert(file, new QImage(image), static_cast<int>(image.sizeInBytes()/1024) + 1);
+    emit ready();
+}
+
+void Thumbnailer::requestVideo(const QString &file)
+{
+    if(!m_pending.contains(file)) {
+        return;
+    }
+
+    m_videoQueue.prepend(file);
+    while(m_videoQueue.size() > tune::grid::queueSize) {
+        m_pending.remove(m_videoQueue.takeLast());
+    }
+
+    nextVideo();
+}
+
+void Thumbnailer::loadVideo()
+{
+    // default future reports itself started, so the flag is the only reliable state
+    if(m_vlcLoading) {
+        return;
+    }
+
+    m_vlcLoading = true;
+
+    // same as `VideoPlayer::warmUp`: plugins loading would stall grid scrolling for hundreds of ms
+    QThread *guiThread { thread() };
+    m_vlcWatcher.setFuture(QtConcurrent::run([guiThread]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        // no window, no sound. frames are only decoded for snapshots
+        VlcInstance *vlc { new VlcInstance({
+            "--intf=dummy",
+            "--vout=dummy",
+            "--no-audio",
+            "--no-video-title-show",
+            "--no-stats",
+            "--no-sub-autodetect-file",
+            "--no-snapshot-preview",
+        }) };
+        vlc->moveToThread(guiThread);
+
+        qDebug() << "thumbnails libvlc initialized in" << timer.elapsed() << "ms";
+        return vlc;
+    }));
+}
+
+void Thumbnailer::initVideo()
+{
+    if(m_vlcWatcher.future().resultCount() == 0) {
+        return;
+    }
+
+    m_vlc.reset(m_vlcWatcher.result());
+    m_videoPlayer.reset(new VlcMediaPlayer(m_vlc.data()));
+
+    connect(m_videoPlayer.data(), &VlcMediaPlayer::vout, this, [this]() {
+        if(m_videoFile.isEmpty()) {
+            return;
+        }
+
+        // the very first frame is black too often
+        m_videoPlayer->setPosition(tune::grid::videoPosition);
+        m_videoSeeked = true;
+    });
+
+    connect(m_videoPlayer.data(), &VlcMediaPlayer::positionChanged, this, [this]() {
+        if(!m_videoSeeked) {
+            return;
+        }
+
+        // every snapshot is named apart: the previous one may still be read by a worker
+        m_videoSeeked = false;
+        const QString snapshot { m_snapshotDir.filePath(QStringLiteral("snapshot-%1.png").arg(++m_snapshotCount)) };
+        if(!m_videoPlayer->video()->takeSnapshot(snapshot)) {
+            finishVideo(true);
+        }
+    });
+
+    connect(m_videoPlayer.data(), &VlcMediaPlayer::snapshotTaken, this, [this](const QString &file) {
+        if(m_videoFile.isEmpty()) {
+            return;
+        }
+
+        // decoded and stored by a worker, the gui thread only moves to the next video
+        if(m_pending.contains(m_videoFile)) {
+            QtConcurrent::run(&m_pool, [this, file, videoFile = m_videoFile, size = m_size]() {
+                const QImage image { ImageCache::decode(file, size).image };
+                QFile::remove(file);
+                deliver(videoFile, image, size, true);
+            });
+        } else {
+            QFile::remove(file);
+        }
+        finishVideo(false);
+    });
+
+    connect(m_videoPlayer.data(), &VlcMediaPlayer::error, this, [this]() {
+        if(!m_videoFile.isEmpty()) {
+            finishVideo(true);
+        }
+    });
+}
+
+void Thumbnailer::nextVideo()
+{
+    if(!m_videoFile.isEmpty() || m_videoQueue.isEmpty()) {
+        return;
+    }
+
+    // queue is resumed once libvlc is loaded
+    if(!m_vlc) {
+        loadVideo();
+        return;
+    }
+
+    m_videoFile = m_videoQueue.takeFirst();
+    m_videoSeeked = false;
+
+    if(m_videoMedia) {
+        delete m_videoMedia;
+    }
+    m_videoMedia = new VlcMedia(m_videoFile, true, m_vlc.data());
+    m_videoPlayer->open(m_videoMedia);
+
+    // broken and endless streams must not stall the queue
+    m_videoTimer.start(tune::grid::videoTimeout);
+}
+
+void Thumbnailer::finishVideo(bool failed)
+{
+    m_videoTimer.stop();
+    m_videoPlayer->stop();
+
+    const QString file { m_videoFile };
+    m_videoFile.clear();
+    if(failed && m_pending.contains(file)) {
+        insert(file, QImage());
+    }
+
+    nextVideo();
+}
+
+} // namespace pork
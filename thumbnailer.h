@@ -0,0 +1,80 @@
+#ifndef THUMBNAILER_H
+#define THUMBNAILER_H
+
+#include <QObject>
+#include <QImage>
+#include <QCache>
+#include <QSet>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimer>
+#include <QTemporaryDir>
+#include <QScopedPointer>
+#include <QFutureWatcher>
+
+class VlcInstance;
+class VlcMediaPlayer;
+class VlcMedia;
+
+namespace pork {
+
+//! Makes thumbnails of directory files in background. Pictures are decoded by a worker pool
+//! at reduced size, videos are snapshotted one by one by a separate headless libvlc player.
+//! Thumbnails made once are read back from `PreviewStore` by the workers.
+//! The latest requested thumbnails go first, so visible ones win over scrolled away ones.
+class Thumbnailer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Thumbnailer(QObject *parent = 0);
+    ~Thumbnailer();
+
+    void setSize(const QSize &size);
+    const QSize &size() const { return m_size; }
+
+    //! Returns cached thumbnail. Null one is returned and generation is scheduled if there is none yet
+    QImage thumbnail(const QString &file);
+
+signals:
+    void ready();
+
+private:
+    void work();
+    //! Fits and stores the thumbnail on a worker, then passes it to the gui thread
+    void deliver(const QString &file, const QImage &image, const QSize &size, bool store);
+    void insert(const QString &file, const QImage &image);
+
+    void requestVideo(const QString &file);
+    void loadVideo();
+    void initVideo();
+    void nextVideo();
+    void finishVideo(bool failed);
+
+    QSize m_size;
+    QCache<QString, QImage> m_thumbnails;
+    QSet<QString> m_pending;
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QList<QString> m_queue; //! the latest requested go first
+    int m_workers {0};
+
+    // videos are snapshotted by the gui thread driven player
+    QList<QString> m_videoQueue;
+    QString m_videoFile;
+    bool m_videoSeeked {false};
+    int m_snapshotCount {0};
+    QTimer m_videoTimer;
+    QTemporaryDir m_snapshotDir;
+    QFutureWatcher<VlcInstance *> m_vlcWatcher; //! libvlc plugins are loaded off the gui thread
+    bool m_vlcLoading {false};
+    QScopedPointer<VlcInstance> m_vlc;
+    QScopedPointer<VlcMediaPlayer> m_videoPlayer;
+    VlcMedia *m_videoMedia {nullptr};
+};
+
+} // namespace pork
+
+#endif // THUMBNAILER_H
@@ -0,0 +1,171 @@
+#include "tiledimage.h"
+#include "config.h"
+#include "filesource.h"
+#include "trace.h"
+
+#include <QImageReader>
+#include <QBuffer>
+#include <QtConcurrent>
+#include <cmath>
+
+namespace pork {
+
+static quint64 tileKey(int level, int x, int y)
+{
+    return static_cast<quint64>(level) << 48 | static_cast<quint64>(y) << 24 | static_cast<quint64>(x);
+}
+
+TiledImage::TiledImage(const QString &file, const QSize &fullSize, QObject *parent)
+    : QObject(parent)
+    , m_file(file)
+    , m_fullSize(fullSize)
+{
+    m_pool.setMaxThreadCount(tune::tiled::threads);
+    m_tiles.setMaxCost(tune::tiled::memoryCap*1024);
+}
+
+TiledImage::~TiledImage()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_queue.clear();
+    }
+    m_pool.waitForDone();
+}
+
+int TiledImage::levelFor(qreal scale)
+{
+    // the most downscaled level which still has enough pixels for the scale
+    if(scale >= 1.0) {
+        return 0;
+    }
+    return static_cast<int>(std::floor(std::log2(1.0/scale)));
+}
+
+QRect TiledImage::tileRect(int level, int x, int y) const
+{
+    const int side { tune::tiled::tileSize << level };
+    return QRect(x*side, y*side, side, side) & QRect(QPoint(), m_fullSize);
+}
+
+QImage TiledImage::tile(int level, int x, int y)
+{
+    const quint64 key { tileKey(level, x, y) };
+    if(QImage *cached = m_tiles.object(key)) {
+        return *cached;
+    }
+
+    if(m_clipUnsupported.loadAcquire() || m_pending.contains(key)) {
+        return QImage();
+    }
+
+    const QRect rect { tileRect(level, x, y) };
+    if(rect.isEmpty()) {
+        return QImage();
+    }
+
+    const int round { (1 << level) - 1 };
+    const QSize scaledSize { (rect.width() + round) >> level, (rect.height() + round) >> level };
+
+    QMutexLocker lock(&m_mutex);
+    m_pending.insert(key);
+    m_queue.prepend(Job { key, rect, scaledSize });
+
+    // tiles user has scrolled away from are dropped
+    while(m_queue.size() > tune::tiled::queueSize) {
+        m_pending.remove(m_queue.takeLast().key);
+    }
+
+    if(m_workers < m_pool.maxThreadCount()) {
+        ++m_workers;
+        QtConcurrent::run(&m_pool, [this]() { work(); });
+    }
+
+    return QImage();
+}
+
+void TiledImage::open()
+{
+    // opened by the first tile worker: files which can't be mapped are read whole
+    m_source = FileSource::open(m_file);
+
+    // without clip rect support every tile would decode the whole picture. overview is all we can show then
+    QBuffer buffer;
+    QImageReader reader;
+    m_source->attach(reader, buffer);
+    if(!reader.supportsOption(QImageIOHandler::ClipRect)) {
+        m_clipUnsupported.storeRelease(1);
+    }
+
+    // orientation is applied by reader as mirroring first, then clockwise rotation
+    const QImageIOHandler::Transformations transformation { reader.transformation() };
+    m_transposed = transformation.testFlag(QImageIOHandler::TransformationRotate90);
+    const QSize stored { m_transposed ? m_fullSize.transposed() : m_fullSize };
+
+    QTransform toDisplayed;
+    if(transformation.testFlag(QImageIOHandler::TransformationMirror)) {
+        toDisplayed *= QTransform(-1, 0, 0, 1, stored.width(), 0);
+    }
+    if(transformation.testFlag(QImageIOHandler::TransformationFlip)) {
+        toDisplayed *= QTransform(1, 0, 0, -1, 0, stored.height());
+    }
+    if(m_transposed) {
+        toDisplayed *= QTransform(0, 1, -1, 0, stored.height(), 0);
+    }
+    m_toStored = toDisplayed.inverted();
+}
+
+void TiledImage::work()
+{
+    forever {
+        Job job;
+        {
+            QMutexLocker lock(&m_mutex);
+            if(m_queue.isEmpty()) {
+                --m_workers;
+                return;
+            }
+            job = m_queue.takeFirst();
+        }
+
+        {
+            QMutexLocker lock(&m_sourceMutex);
+            if(!m_source) {
+                open();
+            }
+        }
+
+        QImage image;
+        if(!m_clipUnsupported.loadAcquire()) {
+            image = decode(job);
+        }
+
+        QMetaObject::invokeMethod(this, [this, job, image]() {
+            // broken tiles are cached as well so they are not requested over and over
+            m_pending.remove(job.key);
+            m_tiles.insert(job.key, new QImage(image), static_cast<int>(image.sizeInBytes()/1024) + 1);
+            if(!image.isNull()) {
+                emit tileReady();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+QImage TiledImage::decode(const Job &job) const
+{
+    // quarter turns and mirrors map pixel edges onto pixel edges, so the rect stays exact
+    const QRect rect { m_toStored.mapRect(QRectF(job.rect)).toAlignedRect() };
+    const QSize scaledSize { m_transposed ? job.scaledSize.transposed() : job.scaledSize };
+
+    // decoders supporting clip rect read only the needed region. it's turned as displayed afterwards
+    PORK_TRACE("TiledImage::decode");
+    QBuffer buffer;
+    QImageReader reader;
+    m_source->attach(reader, buffer);
+    reader.setAutoTransform(true);
+    reader.setClipRect(rect);
+    reader.setScaledSize(scaledSize);
+    return reader.read();
+}
+
+} // namespace pork
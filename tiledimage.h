@@ -0,0 +1,72 @@
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <QObject>
+#include <QImage>
+#include <QCache>
+#include <QSet>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QTransform>
+
+namespace pork {
+
+class FileSource;
+
+//! Picture too big to be decoded at once. It's decoded by tiles on demand:
+//! level `n` tiles are `2^n` times downscaled regions of the picture.
+//! Tiles are addressed in displayed coordinates, EXIF orientation is undone for decoding and reapplied to the tile.
+class TiledImage : public QObject
+{
+    Q_OBJECT
+
+public:
+    TiledImage(const QString &file, const QSize &fullSize, QObject *parent = 0);
+    ~TiledImage();
+
+    const QSize &fullSize() const { return m_fullSize; }
+
+    static int levelFor(qreal scale);
+    QRect tileRect(int level, int x, int y) const;
+    QImage tile(int level, int x, int y);
+
+signals:
+    void tileReady();
+
+private:
+    struct Job
+    {
+        quint64 key;
+        QRect rect;       //! in displayed picture coordinates
+        QSize scaledSize;
+    };
+
+    void open();
+    void work();
+    QImage decode(const Job &job) const;
+
+    QString m_file;
+    QSize m_fullSize;           //! as displayed, i.e. transposed for 90 and 270 degrees orientations
+
+    // set once by the first worker
+    QMutex m_sourceMutex;
+    QSharedPointer<FileSource> m_source; //! tiles are decoded from the same mapping
+    QTransform m_toStored;      //! maps displayed coordinates to stored ones
+    bool m_transposed {false};
+    QAtomicInt m_clipUnsupported {0};
+
+    QThreadPool m_pool;
+    QCache<quint64, QImage> m_tiles;
+    QSet<quint64> m_pending;
+
+    QMutex m_mutex;
+    QList<Job> m_queue; //! the latest requested tiles go first
+    int m_workers {0};
+};
+
+} // namespace pork
+
+#endif // TILEDIMAGE_H
@@ -0,0 +1,201 @@
+#include "trace.h"
+#include "config.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutex>
+#include <QSaveFile>
+#include <QByteArrayList>
+#include <QDebug>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace pork {
+
+namespace trace
+{
+    std::atomic<bool> enabled {false};
+}
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    qint64 start;
+    qint64 duration; //! negative for instant events
+};
+
+//! written by its thread only. `count` publishes events to `dump`
+struct Buffer
+{
+    std::unique_ptr<Event[]> events { new Event[tune::trace::threadEvents] };
+    std::atomic<int> count {0};
+    std::atomic<int> session {0}; //! recording the events belong to
+    int tid {0};
+    QByteArray threadName;
+};
+
+QMutex registryMutex;
+std::vector<std::unique_ptr<Buffer>> registry; //! buffers outlive their threads, so pool threads may expire before the dump
+std::vector<Buffer *> spare;                   //! buffers of finished threads. new threads continue them
+std::atomic<int> session {0};
+std::atomic<qint64> startTime {0};
+
+//! gives the buffer back when its thread finishes, so pool threads coming and going don't grow the registry
+struct Lease
+{
+    Buffer *buffer {nullptr};
+
+    ~Lease()
+    {
+        if(buffer) {
+            QMutexLocker lock(&registryMutex);
+            spare.push_back(buffer);
+        }
+    }
+};
+
+thread_local Lease localBuffer;
+
+Buffer *threadBuffer()
+{
+    if(localBuffer.buffer) {
+        return localBuffer.buffer;
+    }
+
+    QThread *thread { QThread::currentThread() };
+    const QCoreApplication *app { QCoreApplication::instance() };
+    QByteArray threadName { app && thread == app->thread() ? QByteArray("gui") : thread->objectName().toUtf8() };
+
+    QMutexLocker lock(&registryMutex);
+    Buffer *buffer {nullptr};
+    if(spare.empty()) {
+        registry.emplace_back(new Buffer);
+        buffer = registry.back().get();
+        buffer->tid = static_cast<int>(registry.size());
+    } else {
+        // events of the finished thread stay, the new one goes on in the same lane
+        buffer = spare.back();
+        spare.pop_back();
+    }
+
+    buffer->threadName = threadName.isEmpty() ? "thread " + QByteArray::number(buffer->tid) : threadName;
+    localBuffer.buffer = buffer;
+    return buffer;
+}
+
+void append(const char *name, qint64 start, qint64 duration)
+{
+    Buffer *buffer { threadBuffer() };
+
+    // events of the previous recordings are dumped or abandoned already
+    const int current { session.load(std::memory_order_relaxed) };
+    if(buffer->session.load(std::memory_order_relaxed) != current) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->session.store(current, std::memory_order_release);
+    }
+
+    const int count { buffer->count.load(std::memory_order_relaxed) };
+
+    // full buffer drops the rest of the session. dump tells about it
+    if(count >= tune::trace::threadEvents) {
+        return;
+    }
+
+    buffer->events[count] = Event { name, start, duration };
+    buffer->count.store(count + 1, std::memory_order_release);
+}
+
+} // namespace
+
+namespace trace
+{
+    qint64 now()
+    {
+        static const auto epoch { std::chrono::steady_clock::now() };
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void start()
+    {
+        // buffers are reset by their threads on the first event of the new session
+        session.fetch_add(1);
+        startTime.store(now());
+        enabled.store(true);
+    }
+
+    void stop()
+    {
+        enabled.store(false);
+    }
+
+    void record(const char *name, qint64 start, qint64 duration)
+    {
+        append(name, start, duration);
+    }
+
+    void instant(const char *name)
+    {
+        if(isEnabled()) {
+            append(name, now(), -1);
+        }
+    }
+
+    bool dump(const QString &path)
+    {
+        const qint64 from { startTime.load() };
+        const int current { session.load() };
+        QByteArrayList events;
+        int dropped {0};
+
+        QMutexLocker lock(&registryMutex);
+        for(const auto &buffer : registry) {
+            const QByteArray tid { QByteArray::number(buffer->tid) };
+            events << "{\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"name\":\"thread_name\",\"args\":{\"name\":\"" + buffer->threadName + "\"}}";
+
+            // threads which recorded nothing this session hold events of the previous one
+            if(buffer->session.load(std::memory_order_acquire) != current) {
+                continue;
+            }
+
+            const int count { buffer->count.load(std::memory_order_acquire) };
+            if(count >= tune::trace::threadEvents) {
+                ++dropped;
+            }
+
+            for(int i = 0; i < count; ++i) {
+                const Event &event { buffer->events[i] };
+                if(event.start < from) {
+                    continue;
+                }
+
+                // chrome trace timestamps are in us
+                QByteArray json { "{\"pid\":1,\"tid\":" + tid + ",\"name\":\"" + event.name + "\",\"ts\":" + QByteArray::number(event.start/1000.0, 'f', 3) };
+                if(event.duration < 0) {
+                    json += ",\"ph\":\"i\",\"s\":\"t\"}";
+                } else {
+                    json += ",\"ph\":\"X\",\"dur\":" + QByteArray::number(event.duration/1000.0, 'f', 3) + "}";
+                }
+                events << json;
+            }
+        }
+        lock.unlock();
+
+        const QByteArray json { "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" + events.join(",\n") + "\n]}\n" };
+
+        if(dropped) {
+            qDebug() << dropped << "threads filled their trace buffers, later events are lost";
+        }
+
+        QSaveFile file(path);
+        if(!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+            qDebug() << "cannot write trace" << path << file.errorString();
+            return false;
+        }
+        return true;
+    }
+}
+
+} // namespace pork
@@ -0,0 +1,63 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <atomic>
+
+namespace pork {
+
+//! Recording of the load and render pipeline in Chrome trace format, viewable in `chrome://tracing` or ui.perfetto.dev.
+//! Every thread writes its events to its own buffer without locks.
+//! While tracing is disabled a span costs a single relaxed atomic load.
+namespace trace
+{
+    extern std::atomic<bool> enabled;
+
+    inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    void start();
+    void stop();
+
+    //! writes events recorded since the last `start` as JSON. returns false on I/O error
+    bool dump(const QString &path);
+
+    qint64 now(); //! in ns
+
+    //! `name` must outlive the recording. string literals only
+    void record(const char *name, qint64 start, qint64 duration);
+    void instant(const char *name);
+
+    //! span lasting till the end of the scope
+    class Span
+    {
+    public:
+        explicit Span(const char *name)
+            : m_name { isEnabled() ? name : nullptr }
+            , m_start { m_name ? now() : 0 }
+        {}
+
+        ~Span()
+        {
+            if(m_name) {
+                record(m_name, m_start, now() - m_start);
+            }
+        }
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+    private:
+        const char *m_name;
+        qint64 m_start;
+    };
+}
+
+} // namespace pork
+
+#define PORK_TRACE_CONCAT_(a, b) a##b
+#define PORK_TRACE_CONCAT(a, b) PORK_TRACE_CONCAT_(a, b)
+
+//! traces the rest of the scope as `name` span
+#define PORK_TRACE(name) const pork::trace::Span PORK_TRACE_CONCAT(traceSpan, __LINE__) { name }
+
+#endif // TRACE_H
@@ -1,14 +1,26 @@
 #include "utils.h"
 #include "config.h"
+#include "classifier.h"
 
 #include <QScrollArea>
 #include <QScrollBar>
 #include <QEvent>
-#include <QDirIterator>
+#include <QDir>
+#include <QFile>
 #include <QApplication>
 #include <QDesktopWidget>
 #include <QLabel>
 #include <QScreen>
+#include <QElapsedTimer>
+
+#ifdef Q_OS_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
 
 namespace pork {
 
@@ -53,46 +65,86 @@ void block(QWidget *w) {
     w->installEventFilter(blocker);
 }
 
-bool fileBelongsTo(const QString &file, const QStringList &list)
+void scanDir(const QString &path, const std::function<bool(const QStringList &)> &sink)
 {
-    int dotIndex = file.lastIndexOf('.');
-    if(dotIndex == -1) {
-        // no extension
-        return false;
-    }
+    QStringList batch;
+    MediaMode mode;
 
-    const int fileExtLength = file.length() - dotIndex - 1;
-    const auto fileExt = file.right(fileExtLength);
+    // names are filtered by extension only, so nothing is stat-ed
+    auto add = [&](const QString &fileName) {
+        if(!classify(fileName, mode)) {
+            return true;
+        }
 
-    for(const auto &ext : list) {
-        if(fileExt.compare(ext, Qt::CaseInsensitive) == 0) {
+        batch << fileName;
+        if(batch.size() < tune::dir::batchSize) {
             return true;
         }
+
+        const bool more { sink(batch) };
+        batch.clear();
+        return more;
+    };
+
+#ifdef Q_OS_WIN
+    WIN32_FIND_DATAW data;
+    const std::wstring pattern { QDir::toNativeSeparators(QDir(path).filePath("*")).toStdWString() };
+    HANDLE handle { FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH) };
+    if(handle == INVALID_HANDLE_VALUE) {
+        return;
     }
-    return false;
-}
 
-QStringList getWildcardsFromExtentions(const QStringList& l)
-{
-    QStringList res;
-    for(const auto& ext : l) {
-        res << "*." + ext;
+    bool more {true};
+    do {
+        if(!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            more = add(QString::fromWCharArray(data.cFileName));
+        }
+    } while(more && FindNextFileW(handle, &data));
+    FindClose(handle);
+
+    if(!more) {
+        return;
+    }
+#else
+    DIR *dir { opendir(QFile::encodeName(path).constData()) };
+    if(!dir) {
+        return;
     }
 
-    return res;
-}
+    bool more {true};
+    while(more) {
+        const dirent *entry { readdir(dir) };
+        if(!entry) {
+            break;
+        }
 
-QFileInfoList getDirFiles(const QString &path)
-{
-    QFileInfoList res;
+#ifdef DT_DIR
+        // unknown types are possible on some network file systems. such entries are let through
+        if(entry->d_type == DT_DIR) {
+            continue;
+        }
+#endif
+        more = add(QFile::decodeName(entry->d_name));
+    }
+    closedir(dir);
 
-    static const QStringList filters = getWildcardsFromExtentions(cap::supportedFormats());
+    if(!more) {
+        return;
+    }
+#endif
 
-    QDirIterator it(path, filters, QDir::Files);
-    while(it.hasNext()) {
-        it.next();
-        res << it.fileInfo();
+    if(!batch.isEmpty()) {
+        sink(batch);
     }
+}
+
+QStringList getDirFiles(const QString &path)
+{
+    QStringList res;
+    scanDir(path, [&res](const QStringList &batch) {
+        res << batch;
+        return true;
+    });
     return res;
 }
 
@@ -111,20 +163,33 @@ QRect screen()
     return fitstScreen->geometry();
 }
 
-void centerScrollArea(QScrollArea *area, QLabel* label)
+QImage toDisplayFormat(const QImage &image, bool reduceDeepColor)
 {
-    const auto& screens = QGuiApplication::screens();
-    if(screens.empty()) {
-        return;
+    if(image.isNull() || image.format() == QImage::Format_ARGB32_Premultiplied || image.format() == QImage::Format_RGB32) {
+        return image;
+    }
+
+    bool deep { image.depth() == 64 };
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    deep = deep || image.format() == QImage::Format_Grayscale16;
+#endif
+
+    if(deep && !reduceDeepColor) {
+        return image.format() == QImage::Format_RGBA64_Premultiplied ? image : image.convertToFormat(QImage::Format_RGBA64_Premultiplied);
     }
 
-    QRect scr { screen() };
-    auto pixmap { label->pixmap() };
-    int w { (pixmap->width() - scr.width() + tune::screen::reserve)/2 };
-    int h { (pixmap->height() - scr.height() + tune::screen::reserve)/2 };
+    return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+}
+
+//! Time since the first call which is the very beginning of `main`. in ms
+qint64 uptime()
+{
+    static QElapsedTimer timer;
+    if(!timer.isValid()) {
+        timer.start();
+    }
 
-    area->horizontalScrollBar()->setValue(w);
-    area->verticalScrollBar()->setValue(h);
+    return timer.elapsed();
 }
 
 QString toString(QRgb color)
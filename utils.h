@@ -4,9 +4,10 @@
 #include <QWidget>
 #include <QProxyStyle>
 #include <QFileInfoList>
+#include <QImage>
+#include <functional>
 
 class QAbstractScrollArea;
-class QScrollArea;
 class QLabel;
 
 namespace pork {
@@ -17,6 +18,13 @@ enum Direction
     Forward,
 };
 
+enum MediaMode
+{
+    Image = 0,
+    Gif,
+    Video
+};
+
 //! This makes QSliders set their position strictly to the pointed position instead of stepping
 class QSliderStyle : public QProxyStyle
 {
@@ -35,10 +43,16 @@ public:
 void block(QAbstractScrollArea *w);
 void block(QWidget *w);
 
-bool fileBelongsTo(const QString &file, const QStringList &list);
-QFileInfoList getDirFiles(const QString &path);
+//! Lists supported files of a directory in batches as they are read, without stat-ing them.
+//! Listing stops once `sink` returns false
+void scanDir(const QString &path, const std::function<bool(const QStringList &)> &sink);
+QStringList getDirFiles(const QString &path);
 QRect screen();
-void centerScrollArea(QScrollArea *area, QLabel* label);
+
+//! Converts to the format painted and resampled as is: `RGB32` or `ARGB32_Premultiplied`.
+//! Deep color pictures are kept at 16 bits per channel (premultiplied) if `reduceDeepColor` is off
+QImage toDisplayFormat(const QImage &image, bool reduceDeepColor = true);
+qint64 uptime();
 
 inline QString toString(QRgb color);
 void setLabelText(QLabel *label, const QString &text, QRgb color, int fontSize = -1, bool bold = false);
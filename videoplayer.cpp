@@ -1,9 +1,13 @@
 #include "videoplayer.h"
 #include "config.h"
+#include "watchdog.h"
 
 #include <QSlider>
 #include <QLabel>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
 
 #include <VLCQtCore/Common.h>
 #include <VLCQtCore/Media.h>
@@ -15,20 +19,102 @@
 namespace pork
 {
 
+//! trace event names must be literals
+static const char *traceName(Vlc::State state, bool active)
+{
+    switch(state) {
+        case Vlc::Opening:   return active ? "vlc opening" : "vlc standby opening";
+        case Vlc::Buffering: return active ? "vlc buffering" : "vlc standby buffering";
+        case Vlc::Playing:   return active ? "vlc playing" : "vlc standby playing";
+        case Vlc::Paused:    return active ? "vlc paused" : "vlc standby paused";
+        case Vlc::Stopped:   return active ? "vlc stopped" : "vlc standby stopped";
+        case Vlc::Ended:     return active ? "vlc ended" : "vlc standby ended";
+        case Vlc::Error:     return active ? "vlc error" : "vlc standby error";
+        default:             return active ? "vlc idle" : "vlc standby idle";
+    }
+}
+
 VideoPlayer::VideoPlayer(QWidget *parent)
-    : m_vlc(VlcCommon::args(), parent)
-    , m_player(&m_vlc)
-{}
+    : QObject(parent)
+{
+    connect(&m_vlcWatcher, &QFutureWatcher<VlcInstance *>::finished, this, &VideoPlayer::init);
+}
+
+VideoPlayer::~VideoPlayer()
+{
+    // warm-up result nobody has taken yet
+    if(!m_vlc && m_vlcLoading) {
+        m_vlcWatcher.waitForFinished();
+        if(m_vlcWatcher.future().resultCount() > 0) {
+            delete m_vlcWatcher.result();
+        }
+    }
+}
+
+void VideoPlayer::warmUp()
+{
+    // default future reports itself started and finished, so the flag is the only reliable state
+    if(m_vlc || m_vlcLoading) {
+        return;
+    }
+
+    m_vlcLoading = true;
+
+    // plugins loading takes the most of libvlc startup and needs no gui thread
+    QThread *guiThread { thread() };
+    m_vlcWatcher.setFuture(QtConcurrent::run([guiThread]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        VlcInstance *vlc { new VlcInstance(VlcCommon::args()) };
+        vlc->moveToThread(guiThread);
+
+        qDebug() << "libvlc initialized in" << timer.elapsed() << "ms";
+        return vlc;
+    }));
+}
 
-void VideoPlayer::setWidgets(VlcWidgetVideo *view, QSlider *progress, QSlider *volume, QLabel *codecErrorLabel)
+void VideoPlayer::init()
+{
+    if(m_vlc) {
+        return;
+    }
+
+    // waits for warm-up if it is in progress
+    warmUp();
+    m_vlcWatcher.waitForFinished();
+    if(m_vlcWatcher.future().resultCount() == 0) {
+        return;
+    }
+    m_vlc.reset(m_vlcWatcher.result());
+
+    m_firstPlayer.reset(new VlcMediaPlayer(m_vlc.data()));
+    m_secondPlayer.reset(new VlcMediaPlayer(m_vlc.data()));
+    m_player = m_firstPlayer.data();
+    m_standby = m_secondPlayer.data();
+
+    m_player->setVideoWidget(m_view);
+    m_standby->setVideoWidget(m_standbyView);
+
+    connectPlayer(m_player);
+    connectPlayer(m_standby);
+
+    if(!m_pendingPreroll.isEmpty()) {
+        preroll(m_pendingPreroll);
+        m_pendingPreroll.clear();
+    }
+}
+
+void VideoPlayer::setWidgets(VlcWidgetVideo *view, VlcWidgetVideo *standbyView, QSlider *progress, QSlider *volume, QLabel *codecErrorLabel)
 {
     m_view = view;
+    m_standbyView = standbyView;
     m_progressSlider = progress;
     m_volumeSlider = volume;
     m_codecErrorLabel = codecErrorLabel;
 
-    // basic setup
-    m_player.setVideoWidget(view);
+    // basic setup. players are attached in `init`
+    m_standbyView->hide();
 
     // make sliders well-responsible
     m_volumeSlider->setStyle(new QSliderStyle(m_volumeSlider->style()));
@@ -44,8 +130,35 @@ void VideoPlayer::setWidgets(VlcWidgetVideo *view, QSlider *progress, QSlider *v
         showSliders();
     });
 
+    connect(m_progressSlider, &QSlider::sliderPressed, this, [this]() {
+        if(!m_player) {
+            return;
+        }
+        m_userChangedVideoPos = true;
+        m_player->setPosition(m_progressSlider->value()/static_cast<float>(tune::slider::range));
+    });
+    connect(m_progressSlider, &QSlider::sliderReleased, this, [this]() {
+        if(!m_player) {
+            return;
+        }
+        m_userChangedVideoPos = true;
+        m_player->setPosition(m_progressSlider->value()/static_cast<float>(tune::slider::range));
+    });
+
+    // sliders auto-hide
+    m_slidersTimer.setSingleShot(true);
+    connect(&m_slidersTimer, &QTimer::timeout, m_progressSlider, &QSlider::hide);
+    connect(&m_slidersTimer, &QTimer::timeout, m_volumeSlider, &QSlider::hide);
+}
+
+void VideoPlayer::connectPlayer(VlcMediaPlayer *player)
+{
     // video position change
-    connect(&m_player, &VlcMediaPlayer::positionChanged, this, [this](float position) {
+    connect(player, &VlcMediaPlayer::positionChanged, this, [this, player](float position) {
+        if(player != m_player) {
+            return;
+        }
+
         // first video load resulted in 100 volume anyway. this is a workaround.
         if(m_firstLoad) {
             m_firstLoad = false;
@@ -61,17 +174,16 @@ void VideoPlayer::setWidgets(VlcWidgetVideo *view, QSlider *progress, QSlider *v
             m_progressSlider->setValue(static_cast<int>(position*tune::slider::range));
         }
     });
-    connect(m_progressSlider, &QSlider::sliderPressed, this, [this]() {
-        m_userChangedVideoPos = true;
-        m_player.setPosition(m_progressSlider->value()/static_cast<float>(tune::slider::range));
-    });
-    connect(m_progressSlider, &QSlider::sliderReleased, this, [this]() {
-        m_userChangedVideoPos = true;
-        m_player.setPosition(m_progressSlider->value()/static_cast<float>(tune::slider::range));
-    });
+    connect(player, &VlcMediaPlayer::stateChanged, this, [this, player]() {
+        auto state = player->state();
+        if(trace::isEnabled()) {
+            trace::instant(traceName(state, player == m_player));
+        }
+
+        if(player != m_player) {
+            return;
+        }
 
-    connect(&m_player, &VlcMediaPlayer::stateChanged, this, [this]() {
-        auto state = m_player.state();
         // unknown codec case
         if(state == Vlc::Error) {
             m_codecErrorLabel->show();
@@ -80,21 +192,35 @@ void VideoPlayer::setWidgets(VlcWidgetVideo *view, QSlider *progress, QSlider *v
         }
     });
 
-    connect(&m_player, &VlcMediaPlayer::vout, this, [this](int count) {
+    connect(player, &VlcMediaPlayer::vout, this, [this, player](int count) {
         Q_UNUSED(count)
+        // standby player reports its first frame here too
+        if(player != m_player) {
+            trace::instant("vlc standby first frame");
+            return;
+        }
+
+        trace::instant("vlc first frame");
         emit loaded();
     });
-
-    // sliders auto-hide
-    m_slidersTimer.setSingleShot(true);
-    connect(&m_slidersTimer, &QTimer::timeout, m_progressSlider, &QSlider::hide);
-    connect(&m_slidersTimer, &QTimer::timeout, m_volumeSlider, &QSlider::hide);
 }
 
 bool VideoPlayer::load(const QString &file)
 {
+    PORK_TRACE("VideoPlayer::load");
+    PORK_OPERATION("VideoPlayer::load");
+
+    init();
+    if(!m_vlc) {
+        return false;
+    }
     m_currentFile = file;
 
+    if(file == m_standbyFile && m_standby->state() != Vlc::Error) {
+        swapPlayers();
+        return true;
+    }
+
     reload();
 
     return true;
@@ -102,19 +228,82 @@ bool VideoPlayer::load(const QString &file)
 
 bool VideoPlayer::reload()
 {
+    PORK_TRACE("VideoPlayer::reload");
+    PORK_OPERATION("VideoPlayer::reload");
+
+    init();
+    if(!m_vlc) {
+        return false;
+    }
+
     if(m_media) {
         delete m_media;
     }
-    m_media = new VlcMedia(m_currentFile, true, &m_vlc);
-    m_player.open(m_media);
-    m_player.play();
-    m_audio = m_player.audio();
+    m_media = new VlcMedia(m_currentFile, true, m_vlc.data());
+    m_player->open(m_media);
+    m_player->play();
+    m_audio = m_player->audio();
 
     showSliders();
 
     return true;
 }
 
+void VideoPlayer::preroll(const QString &file)
+{
+    PORK_TRACE("VideoPlayer::preroll");
+
+    if(file == m_standbyFile || file == m_currentFile) {
+        return;
+    }
+
+    // neighbour video is a good reason to load libvlc, but not to block navigation for it
+    if(!m_vlc) {
+        m_pendingPreroll = file;
+        warmUp();
+        return;
+    }
+
+    m_standby->stop();
+    if(m_standbyMedia) {
+        delete m_standbyMedia;
+    }
+
+    // opens demuxer and decoders, shows the first frame and waits for `swapPlayers`
+    m_standbyFile = file;
+    m_standbyMedia = new VlcMedia(m_standbyFile, true, m_vlc.data());
+    m_standbyMedia->setOption(QStringLiteral(":start-paused"));
+    m_standby->open(m_standbyMedia);
+}
+
+void VideoPlayer::swapPlayers()
+{
+    PORK_TRACE("VideoPlayer::swapPlayers");
+
+    m_player->stop();
+
+    std::swap(m_player, m_standby);
+    std::swap(m_view, m_standbyView);
+    std::swap(m_media, m_standbyMedia);
+    m_standbyFile.clear();
+
+    m_standbyView->hide();
+    m_view->show();
+
+    m_audio = m_player->audio();
+    if(m_audio) {
+        m_audio->setVolume(m_volumeSlider->value());
+    }
+    m_player->play();
+
+    showSliders();
+
+    // otherwise `vout` is not reported yet and will do it itself
+    if(videoSize().isValid()) {
+        emit loaded();
+    }
+}
+
 void VideoPlayer::rewind(Direction dir)
 {
     m_userChangedVideoPos = true;
@@ -124,7 +313,7 @@ void VideoPlayer::rewind(Direction dir)
         step *= -1;
     }
 
-    m_player.setPosition(m_player.position() + static_cast<float>(step));
+    m_player->setPosition(m_player->position() + static_cast<float>(step));
 }
 
 void VideoPlayer::showSliders()
@@ -137,20 +326,20 @@ void VideoPlayer::showSliders()
 
 void VideoPlayer::resume()
 {
-    auto state = m_player.state();
+    auto state = m_player->state();
     if(state == Vlc::Paused) {
-        m_player.resume();
+        m_player->resume();
     } else if(state == Vlc::Ended) {
-        m_player.setPosition(0);
-        m_player.play();
+        m_player->setPosition(0);
+        m_player->play();
     }
 }
 
 void VideoPlayer::toggle()
 {
-    auto state = m_player.state();
+    auto state = m_player->state();
     if(state == Vlc::Paused || state == Vlc::Playing) {
-        m_player.togglePause();
+        m_player->togglePause();
     } else if(state == Vlc::Ended) {
         reload();
     }
@@ -158,7 +347,7 @@ void VideoPlayer::toggle()
 
 const QSizeF VideoPlayer::videoSize()
 {
-    return m_player.video()->size();
+    return m_player->video()->size();
 }
 
 } // namespace pork
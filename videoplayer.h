@@ -6,6 +6,9 @@
 #include <VLCQtCore/Instance.h>
 #include <VLCQtCore/MediaPlayer.h>
 
+#include <QFutureWatcher>
+#include <QScopedPointer>
+
 class VlcWidgetVideo;
 class QSlider;
 class QLabel;
@@ -13,41 +16,62 @@ class QLabel;
 namespace pork
 {
 
+//! libvlc is loaded on the first video request or by `warmUp` in advance.
+//! Image-only sessions never pay for its plugins.
 class VideoPlayer : public QObject
 {
     Q_OBJECT
 
 public:
     VideoPlayer(QWidget *parent = 0);
-    void setWidgets(VlcWidgetVideo *view, QSlider *progress, QSlider *volume, QLabel *codecErrorLabel);
+    ~VideoPlayer();
+    void setWidgets(VlcWidgetVideo *view, VlcWidgetVideo *standbyView, QSlider *progress, QSlider *volume, QLabel *codecErrorLabel);
 
     bool load(const QString &file);
     bool reload();
+    void preroll(const QString &file);
+    void warmUp();
 
     void rewind(Direction dir);
     void resume();
     void toggle();
     void showSliders();
 
-    void stop() { m_player.stop(); }
+    void stop() { if(m_player) m_player->stop(); }
 
     const QSizeF videoSize();
+    VlcWidgetVideo *view() const { return m_view; }
 
 signals:
     void loaded();
 
 private:
-    VlcInstance m_vlc;
-    VlcMediaPlayer m_player;
+    void init();
+    void connectPlayer(VlcMediaPlayer *player);
+    void swapPlayers();
+
+    QFutureWatcher<VlcInstance *> m_vlcWatcher;
+    bool m_vlcLoading {false};
+    QScopedPointer<VlcInstance> m_vlc;
+    QScopedPointer<VlcMediaPlayer> m_firstPlayer;
+    QScopedPointer<VlcMediaPlayer> m_secondPlayer;
+
+    //! active one is shown, standby one holds the next video paused at its first frame
+    VlcMediaPlayer *m_player {nullptr};
+    VlcMediaPlayer *m_standby {nullptr};
     VlcWidgetVideo *m_view {nullptr};
+    VlcWidgetVideo *m_standbyView {nullptr};
     QSlider *m_progressSlider {nullptr};
     QSlider *m_volumeSlider {nullptr};
     QLabel *m_codecErrorLabel {nullptr};
 
     VlcMedia *m_media {nullptr};
+    VlcMedia *m_standbyMedia {nullptr};
     VlcAudio *m_audio {nullptr};
 
     QString m_currentFile;
+    QString m_standbyFile;
+    QString m_pendingPreroll;
     QTimer m_slidersTimer;
     bool m_userChangedVideoPos {false};
     bool m_firstLoad {true};
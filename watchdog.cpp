@@ -0,0 +1,133 @@
+#include "watchdog.h"
+#include "config.h"
+#include "utils.h"
+
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDir>
+#include <QDebug>
+
+namespace pork {
+
+namespace {
+
+// set by gui thread only
+std::atomic<const char *> operation {nullptr};
+std::atomic<const char *> finishedOperation {nullptr};
+std::atomic<qint64> finishedDuration {0};
+
+} // namespace
+
+Watchdog::Operation::Operation(const char *name)
+    : m_name { operation.load(std::memory_order_relaxed) ? nullptr : name }
+{
+    if(m_name) {
+        m_start = uptime();
+        operation.store(m_name, std::memory_order_release);
+    }
+}
+
+Watchdog::Operation::~Operation()
+{
+    if(m_name) {
+        finishedDuration.store(uptime() - m_start, std::memory_order_relaxed);
+        finishedOperation.store(m_name, std::memory_order_release);
+        operation.store(nullptr, std::memory_order_release);
+    }
+}
+
+Watchdog::Watchdog(int threshold, QObject *parent)
+    : QThread(parent)
+    , m_threshold(threshold)
+{
+    const QString dir { QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) };
+    QDir().mkpath(dir);
+    m_log.setFileName(QDir(dir).filePath("stalls.log"));
+
+    // the beat is late as long as gui thread is busy
+    m_lastBeat = uptime();
+    m_heartbeat.setInterval(tune::watchdog::heartbeat);
+    connect(&m_heartbeat, &QTimer::timeout, this, [this]() {
+        m_lastBeat.store(uptime(), std::memory_order_relaxed);
+    });
+    m_heartbeat.start();
+}
+
+Watchdog::~Watchdog()
+{
+    requestInterruption();
+    wait();
+}
+
+void Watchdog::run()
+{
+    bool stalled {false};
+    bool hangReported {false};
+    qint64 stallBeat {0};
+    const char *stallOperation {nullptr};
+
+    while(!isInterruptionRequested()) {
+        msleep(tune::watchdog::checkInterval);
+
+        const qint64 now { uptime() };
+        const qint64 beat { m_lastBeat.load(std::memory_order_relaxed) };
+        const qint64 late { now - beat - tune::watchdog::heartbeat };
+
+        if(!stalled) {
+            if(late > m_threshold) {
+                // gui thread is still inside the operation, so this is the moment to take its tag
+                stalled = true;
+                hangReported = false;
+                stallBeat = beat;
+                stallOperation = operation.load(std::memory_order_acquire);
+            }
+            continue;
+        }
+
+        const QString name { stallOperation ? QString::fromLatin1(stallOperation) : QStringLiteral("unknown operation") };
+
+        if(beat == stallBeat) {
+            // it may never end. the log has to tell about it before the process is killed
+            if(!hangReported && late > tune::watchdog::hangTime) {
+                hangReported = true;
+                log(QStringLiteral("hang over %1 ms in %2").arg(late).arg(name));
+            }
+            continue;
+        }
+
+        stalled = false;
+        const qint64 duration { beat - stallBeat - tune::watchdog::heartbeat };
+        // the operation is over by now unless another one of the same name has run since
+        if(stallOperation && finishedOperation.load(std::memory_order_acquire) == stallOperation) {
+            log(QStringLiteral("stall %1 ms in %2 which took %3 ms").arg(duration).arg(name).arg(finishedDuration.load(std::memory_order_relaxed)));
+        } else {
+            log(QStringLiteral("stall %1 ms in %2").arg(duration).arg(name));
+        }
+    }
+}
+
+void Watchdog::log(const QString &line)
+{
+    qDebug() << line;
+
+    // the oldest file is dropped, the rest are shifted by one
+    if(m_log.size() > tune::watchdog::logSize) {
+        const QString path { m_log.fileName() };
+        QFile::remove(QStringLiteral("%1.%2").arg(path).arg(tune::watchdog::logFiles - 1));
+        for(int i = tune::watchdog::logFiles - 2; i > 0; --i) {
+            QFile::rename(QStringLiteral("%1.%2").arg(path).arg(i), QStringLiteral("%1.%2").arg(path).arg(i + 1));
+        }
+        m_log.close();
+        QFile::rename(path, path + ".1");
+    }
+
+    if(!m_log.isOpen() && !m_log.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qDebug() << "cannot open stall log" << m_log.fileName() << m_log.errorString();
+        return;
+    }
+
+    m_log.write(QStringLiteral("%1 %2\n").arg(QDateTime::currentDateTime().toString(Qt::ISODateWithMs), line).toUtf8());
+    m_log.flush();
+}
+
+} // namespace pork
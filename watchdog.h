@@ -0,0 +1,55 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "trace.h"
+
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <atomic>
+
+namespace pork {
+
+//! Watches the gui event loop from its own thread. When the loop hasn't turned over for longer than the threshold,
+//! the stall is written to a rotating log together with the operation that was running on the gui thread.
+class Watchdog : public QThread
+{
+public:
+    //! Tags the rest of the scope as an operation of the gui thread, it must not be used by other threads.
+    //! The outermost operation is reported, nested ones are ignored
+    class Operation
+    {
+    public:
+        explicit Operation(const char *name);
+        ~Operation();
+
+        Operation(const Operation &) = delete;
+        Operation &operator=(const Operation &) = delete;
+
+    private:
+        const char *m_name; //! null when nested
+        qint64 m_start {0};
+    };
+
+    //! `threshold` in ms
+    explicit Watchdog(int threshold, QObject *parent = 0);
+    ~Watchdog();
+
+protected:
+    virtual void run() override;
+
+private:
+    void log(const QString &line);
+
+    const int m_threshold;
+    QTimer m_heartbeat;
+    std::atomic<qint64> m_lastBeat {0};
+    QFile m_log;
+};
+
+} // namespace pork
+
+//! tags the rest of the scope for `Watchdog` reports
+#define PORK_OPERATION(name) const pork::Watchdog::Operation PORK_TRACE_CONCAT(operation, __LINE__) { name }
+
+#endif // WATCHDOG_H